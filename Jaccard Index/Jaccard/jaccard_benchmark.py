@@ -0,0 +1,456 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+
+"""
+Benchmark and correctness harness for the Jaccard pipeline of
+附件1_jaccard.py. Synthetic corpora with a controlled similarity
+structure are pushed through the same stages as the real program:
+
+  extraction    building the feature sets of the samples (synthetic PE
+                images in memory, or a real directory/archive)
+  candidates    generating the candidate pairs (inverted index, LSH over
+                ICWS sketches, or the blocked sparse matrix product)
+  verification  computing the exact Jaccard index of each candidate and
+                keeping the pairs above the threshold
+  output        streaming the edges to an edge file
+
+and each stage reports its throughput and the peak memory of the
+process. On small corpora the resulting edge set is checked against a
+brute-force oracle comparing every pair with jaccard().
+"""
+
+import argparse
+import array
+import collections
+import imp
+import json
+import os
+import resource
+import shutil
+import tempfile
+import time
+import numpy as np
+
+PIPELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)),"附件1_jaccard.py")
+
+def peak_memory():
+    """
+    Return the peak resident set size of the process so far, in bytes
+    (ru_maxrss is in kilobytes on Linux).
+    """
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+class Stages(object):
+    """
+    Time a sequence of stages and record, for each, the wall time, the
+    number of items processed and the peak memory of the process at its
+    end. Since the peak is monotonic, the stage that raised it is the
+    first one whose peak differs from the previous stage.
+    """
+    def __init__(self,size):
+        self.size = size
+        self.records = []
+        self.start = None
+
+    def begin(self):
+        self.start = time.time()
+
+    def end(self,stage,items,unit,seconds=None):
+        if seconds is None:
+            seconds = time.time() - self.start
+        self.records.append(collections.OrderedDict([
+            ("samples",self.size),
+            ("stage",stage),
+            ("seconds",seconds),
+            ("items",items),
+            ("unit",unit),
+            ("throughput",items / seconds if seconds > 0 else float("inf")),
+            ("peak_memory",peak_memory()),
+        ]))
+
+    def report(self):
+        for record in self.records:
+            print "{0:>9} {1:<13} {2:>9.3f}s {3:>11} {4:<8} {5:>13.1f}/s {6:>9.1f} MB".format(
+                record["samples"],record["stage"],record["seconds"],record["items"],
+                record["unit"],record["throughput"],record["peak_memory"] / 1048576.0)
+
+def synthetic_strings(random,count):
+    """
+    Draw 'count' distinct-looking printable strings.
+    """
+    return [b"s%016x" % value for value in random.randint(0,1 << 62,size=count,dtype=np.int64)]
+
+def synthetic_corpus(num_samples,family_size,strings_per_sample,keep,noise,common,seed):
+    """
+    Generate the string sets of a synthetic corpus of 'num_samples'
+    samples with a controlled similarity structure: samples come in
+    families of 'family_size', every family has its own base set of
+    'strings_per_sample' strings, and every sample keeps each base
+    string with probability 'keep', adds 'noise' strings of its own and
+    draws 'common' strings from a small corpus-wide pool (library and
+    compiler strings, the candidates for stop strings). Two samples of
+    a family then have an expected Jaccard index of about
+    keep / (2 - keep) when the noise is small, and samples of different
+    families share only common strings.
+    """
+    random = np.random.RandomState(seed)
+    pool = synthetic_strings(random,max(common * 8,1))
+    for family in range(0,num_samples,family_size):
+        base = synthetic_strings(random,strings_per_sample)
+        for member in range(min(family_size,num_samples - family)):
+            kept = random.random_sample(len(base)) < keep
+            strings = [string for string,k in zip(base,kept) if k]
+            strings.extend(synthetic_strings(random,noise))
+            if common:
+                # Zipf-like popularity, so a few pool strings are in every sample
+                ranks = np.minimum(random.zipf(1.5,size=common),len(pool)) - 1
+                strings.extend(pool[rank] for rank in ranks)
+            yield "synthetic/family{0:07d}/sample{1:07d}".format(family // family_size,family + member),strings
+
+def synthetic_image(strings):
+    """
+    Lay the strings out in a minimal image that passes the PE check:
+    an MZ header pointing at a PE signature, followed by the strings
+    separated by NUL bytes.
+    """
+    header = bytearray(0x48)
+    header[0:2] = b"MZ"
+    header[0x3C:0x40] = b"\x40\x00\x00\x00"
+    header[0x40:0x44] = b"PE\0\0"
+    return bytes(header) + b"\0" + b"\0".join(strings) + b"\0"
+
+def extract_synthetic(jaccard,stages,corpus):
+    """
+    Extraction stage over a synthetic corpus: every sample is rendered
+    to a PE image in memory and run through the real feature
+    extraction and hashing. Image generation is not timed.
+    """
+    malware_paths = []
+    malware_attributes = dict()
+    dictionary = jaccard.StringDictionary()
+    total_bytes = 0
+    elapsed = 0.0
+    for path,strings in corpus:
+        image = synthetic_image(strings)
+        start = time.time()
+        if jaccard.data_pecheck(image,len(image)):
+            attributes = jaccard.data_features(image,len(image))
+            malware_attributes[path] = dictionary.intern(jaccard.hash_strings(attributes))
+            malware_paths.append(path)
+        elapsed += time.time() - start
+        total_bytes += len(image)
+    stages.end("extraction",len(malware_paths),"samples",elapsed)
+    print "  {0:.1f} MB of images, {1:.1f} MB/s".format(total_bytes / 1048576.0,total_bytes / 1048576.0 / max(elapsed,1e-9))
+    return malware_paths,malware_attributes
+
+def extract_corpus(jaccard,stages,target,processes):
+    """
+    Extraction stage over a real directory or zip/tar archive of samples.
+    """
+    malware_paths = []
+    malware_attributes = dict()
+    dictionary = jaccard.StringDictionary()
+    stages.begin()
+    for path,sha256,hashes,strings,num_attributes in jaccard.scan_samples(target,("strings",),frozenset(),processes):
+        malware_paths.append(path)
+        malware_attributes[path] = dictionary.intern(hashes)
+    stages.end("extraction",len(malware_paths),"samples")
+    return malware_paths,malware_attributes
+
+def find_edges(jaccard,stages,method,postings,features,args):
+    """
+    Candidate generation and verification stages with the given method.
+    Return the edges as (i, j, jaccard) arrays.
+    """
+    sources = array.array("l")
+    targets = array.array("l")
+    values = array.array("d")
+    stages.begin()
+    if method == "index":
+        counts = array.array("l")
+        for i,j,intersection_length in jaccard.candidate_pairs(postings,features):
+            sources.append(i)
+            targets.append(j)
+            counts.append(intersection_length)
+        stages.end("candidates",len(sources),"pairs")
+        stages.begin()
+        totals = np.array(jaccard.sample_totals(features),dtype=np.float64)
+        i = np.array(sources,dtype=np.int_)
+        j = np.array(targets,dtype=np.int_)
+        intersections = np.array(counts,dtype=np.float64)
+        similarities = intersections / (totals[i] + totals[j] - intersections)
+        keep = similarities > args.threshold
+        stages.end("verification",len(sources),"pairs")
+        return i[keep],j[keep],similarities[keep]
+    if method == "lsh":
+        hashes = [strings.astype(np.uint64) for strings in features]
+        weights = [np.ones(len(h)) for h in hashes]
+        sketches = np.array([jaccard.icws_sketch(h,w,args.sketch_size) for h,w in zip(hashes,weights)]).reshape(-1,args.sketch_size)
+        for i,j in jaccard.lsh_candidates(sketches,args.lsh_bands):
+            sources.append(i)
+            targets.append(j)
+        stages.end("candidates",len(sources),"pairs")
+        stages.begin()
+        for i,j in zip(sources,targets):
+            values.append(jaccard.weighted_jaccard(hashes[i],weights[i],hashes[j],weights[j]))
+        stages.end("verification",len(sources),"pairs")
+    else:
+        matrix = jaccard.jaccard_matrix(postings,features,threads=args.threads)
+        n = len(features)
+        stages.end("candidates",n * (n - 1) // 2,"pairs")
+        stages.begin()
+        for i,j,value in jaccard.matrix_similarities(matrix,args.threshold):
+            sources.append(i)
+            targets.append(j)
+            values.append(value)
+        stages.end("verification",n * (n - 1) // 2,"pairs")
+    i = np.array(sources,dtype=np.int_)
+    j = np.array(targets,dtype=np.int_)
+    similarities = np.array(values,dtype=np.float64)
+    keep = similarities > args.threshold
+    return i[keep],j[keep],similarities[keep]
+
+def write_edges(jaccard,stages,malware_paths,edges,directory,format):
+    """
+    Output stage: stream the nodes and edges to an edge file.
+    """
+    stages.begin()
+    writer = jaccard.EdgeWriter(os.path.join(directory,"edges." + format),format)
+    for path in malware_paths:
+        writer.node(path)
+    for i,j,value in zip(*edges):
+        writer.edge(malware_paths[i],malware_paths[j],value)
+    writer.close()
+    stages.end("output",len(edges[0]),"edges")
+
+def oracle_check(jaccard,features,edges,threshold):
+    """
+    Compare the edge set against a brute-force oracle computing the
+    Jaccard index of every pair with jaccard(). Return the number of
+    missed edges, of spurious edges and the largest difference of the
+    Jaccard index on the edges found by both.
+    """
+    sets = [set(strings.tolist()) for strings in features]
+    expected = dict()
+    for i in range(len(sets)):
+        for j in range(i + 1,len(sets)):
+            value = jaccard.jaccard(sets[i],sets[j])
+            if value > threshold:
+                expected[i,j] = value
+    found = dict(((i,j),value) for i,j,value in zip(*[column.tolist() for column in edges]))
+    missed = len(set(expected) - set(found))
+    spurious = len(set(found) - set(expected))
+    common = set(expected) & set(found)
+    error = max([abs(expected[pair] - found[pair]) for pair in common] or [0.0])
+    return missed,spurious,error
+
+def bbit_report(jaccard,features,num_perm,bit_counts,scheme):
+    """
+    Report the error of the b-bit MinHash estimator against the exact
+    Jaccard index over all pairs of samples, for each number of bits
+    in 'bit_counts' (0 for full 64-bit signatures), with the memory a
+    signature takes and the time to compute the signatures with the
+    given scheme (see FeatureStore.minhash()).
+    """
+    hashes = [strings.astype(np.uint64) for strings in features]
+    signature = jaccard.oph_signature if scheme == "oph" else jaccard.minhash_signature
+    start = time.time()
+    signatures = np.array([signature(h,num_perm) for h in hashes])
+    print "  {0} signatures: {1:.3f}s for {2} strings".format(
+        scheme,time.time() - start,sum(len(h) for h in hashes))
+    n = len(features)
+    first,second = np.triu_indices(n,1)
+    sets = [set(strings.tolist()) for strings in features]
+    exact = np.array([jaccard.jaccard(sets[i],sets[j]) for i,j in zip(first.tolist(),second.tolist())])
+    similar = exact >= 0.5
+    print "{0:>5} {1:>11} {2:>10} {3:>10} {4:>14}".format("bits","bytes/sample","mean error","rmse","rmse (J>=0.5)")
+    for bits in bit_counts:
+        if bits:
+            packed = jaccard.bbit_pack(signatures,bits)
+            matches = np.concatenate([jaccard.bbit_matches(packed[i],packed[i+1:],bits,num_perm) for i in range(n - 1)])
+            estimate = jaccard.bbit_jaccard(matches,num_perm,bits)
+            size = packed.shape[1] * 8
+        else:
+            estimate = (signatures[first] == signatures[second]).mean(axis=1)
+            size = num_perm * 8
+        error = estimate - exact
+        print "{0:>5} {1:>11} {2:>10.4f} {3:>10.4f} {4:>14.4f}".format(
+            bits or 64,size,np.abs(error).mean(),np.sqrt((error ** 2).mean()),
+            np.sqrt((error[similar] ** 2).mean()) if similar.any() else 0.0)
+
+def run(jaccard,size,args,directory):
+    """
+    Run every stage on one corpus and return its stage records and
+    oracle result.
+    """
+    stages = Stages(size)
+    if args.corpus is not None:
+        malware_paths,malware_attributes = extract_corpus(jaccard,stages,args.corpus,args.processes)
+        stages.size = stages.records[0]["samples"] = len(malware_paths)
+    else:
+        corpus = synthetic_corpus(size,args.family_size,args.strings_per_sample,args.keep,
+                                  args.noise,args.common,args.seed)
+        malware_paths,malware_attributes = extract_synthetic(jaccard,stages,corpus)
+
+    stages.begin()
+    postings,features,stop_strings = jaccard.build_inverted_index(malware_paths,malware_attributes,args.max_df)
+    stages.end("index",len(postings),"strings")
+    del malware_attributes
+
+    if args.bbit_report:
+        bbit_report(jaccard,features,args.num_perm,(1,2,3,4,0),args.minhash_scheme)
+
+    edges = find_edges(jaccard,stages,args.method,postings,features,args)
+    write_edges(jaccard,stages,malware_paths,edges,directory,args.edge_format)
+    stages.report()
+
+    oracle = None
+    if len(features) <= args.oracle_limit:
+        missed,spurious,error = oracle_check(jaccard,features,edges,args.threshold)
+        oracle = collections.OrderedDict([("missed",missed),("spurious",spurious),("max_error",error)])
+        print "  oracle: {0} edges, {1} missed, {2} spurious, max error {3:.3g}".format(
+            len(edges[0]),missed,spurious,error)
+    return stages.records,oracle
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description="Benchmark the Jaccard pipeline on synthetic corpora and check it against a brute-force oracle"
+    )
+
+    parser.add_argument(
+        "--sizes",dest="sizes",default="1000,10000",
+        help="Comma-separated corpus sizes (number of samples) to benchmark"
+    )
+
+    parser.add_argument(
+        "--corpus",dest="corpus",default=None,
+        help="Benchmark a real directory or zip/tar archive of samples instead of synthetic corpora"
+    )
+
+    parser.add_argument(
+        "--method",dest="method",choices=("index","lsh","matrix"),default="index",
+        help="Candidate generation: inverted index, LSH over ICWS sketches or the full matrix"
+    )
+
+    parser.add_argument(
+        "--jaccard_index_threshold","-j",dest="threshold",type=float,default=0.8,
+        help="Threshold above which to create an 'edge' between samples"
+    )
+
+    parser.add_argument(
+        "--max_document_frequency","-m",dest="max_df",type=float,default=1.0,
+        help="Drop strings found in more than this fraction (<= 1) or number (> 1) of samples"
+    )
+
+    parser.add_argument(
+        "--family_size",dest="family_size",type=int,default=10,
+        help="Number of samples per synthetic family"
+    )
+
+    parser.add_argument(
+        "--strings_per_sample",dest="strings_per_sample",type=int,default=200,
+        help="Size of the base string set of a synthetic family"
+    )
+
+    parser.add_argument(
+        "--keep",dest="keep",type=float,default=0.95,
+        help="Probability that a sample keeps each base string of its family"
+    )
+
+    parser.add_argument(
+        "--noise",dest="noise",type=int,default=5,
+        help="Number of strings unique to each synthetic sample"
+    )
+
+    parser.add_argument(
+        "--common",dest="common",type=int,default=20,
+        help="Number of strings each synthetic sample draws from the corpus-wide pool"
+    )
+
+    parser.add_argument(
+        "--seed",dest="seed",type=int,default=0,
+        help="Random seed of the synthetic corpora"
+    )
+
+    parser.add_argument(
+        "--lsh_bands",dest="lsh_bands",type=int,default=32,
+        help="Number of LSH bands (--method lsh)"
+    )
+
+    parser.add_argument(
+        "--sketch_size",dest="sketch_size",type=int,default=128,
+        help="Number of ICWS samples per sketch (--method lsh)"
+    )
+
+    parser.add_argument(
+        "--threads","-t",dest="threads",type=int,default=1,
+        help="Number of threads for the Jaccard matrix (--method matrix)"
+    )
+
+    parser.add_argument(
+        "--processes","-p",dest="processes",type=int,default=1,
+        help="Number of processes extracting features from a real corpus"
+    )
+
+    parser.add_argument(
+        "--edge_format",dest="edge_format",choices=("csv","ndjson","bin"),default="csv",
+        help="Format of the edge file written by the output stage"
+    )
+
+    parser.add_argument(
+        "--oracle_limit",dest="oracle_limit",type=int,default=2000,
+        help="Check the edges against the brute-force oracle for corpora up to this size"
+    )
+
+    parser.add_argument(
+        "--bbit_report",dest="bbit_report",action="store_true",
+        help="Also report the error of b-bit MinHash estimates (1-4 bits and 64) over all pairs"
+    )
+
+    parser.add_argument(
+        "--minhash_permutations",dest="num_perm",type=int,default=128,
+        help="Number of MinHash permutations for --bbit_report"
+    )
+
+    parser.add_argument(
+        "--minhash_scheme",dest="minhash_scheme",choices=("independent","oph"),default="oph",
+        help="MinHash scheme for --bbit_report"
+    )
+
+    parser.add_argument(
+        "--report",dest="report",default=None,
+        help="Also write the measurements as JSON to this file"
+    )
+
+    parser.add_argument(
+        "--module",dest="module",default=PIPELINE,
+        help="Path of the Jaccard pipeline to benchmark"
+    )
+
+    args = parser.parse_args()
+    if args.sketch_size % args.lsh_bands:
+        parser.error("--sketch_size must be a multiple of --lsh_bands")
+    sizes = [int(size) for size in args.sizes.split(",") if size]
+    if args.corpus is not None:
+        sizes = [0]
+
+    jaccard = imp.load_source("jaccard_pipeline",args.module)
+    directory = tempfile.mkdtemp()
+    results = []
+    failed = False
+    try:
+        print "{0:>9} {1:<13} {2:>10} {3:>11} {4:<8} {5:>15} {6:>12}".format(
+            "samples","stage","time","items","unit","throughput","peak memory")
+        for size in sizes:
+            records,oracle = run(jaccard,size,args,directory)
+            results.append({"stages": records,"oracle": oracle})
+            if oracle is not None and args.method != "lsh" and (oracle["missed"] or oracle["spurious"]):
+                failed = True
+    finally:
+        shutil.rmtree(directory)
+
+    if args.report is not None:
+        with open(args.report,"w") as f:
+            json.dump(results,f,indent=2)
+    if failed:
+        raise SystemExit("edge sets differ from the brute-force oracle")
@@ -1,13 +1,28 @@
 #!/usr/bin/python
 
 import argparse
+import bisect
+import collections
+import csv
+import hashlib
+import json
+import math
+import mmap
+import multiprocessing
 import os
-import networkx
-from networkx.drawing.nx_pydot import write_dot
+import re
+import SocketServer
+import stat
+import struct
+import tarfile
+import time
+import zipfile
 import itertools
 import pprint
 import matplotlib.pyplot as plt
 import numpy as np
+import scipy.sparse
+from multiprocessing.pool import ThreadPool
 
 
 
@@ -25,23 +40,1786 @@ def jaccard(set1,set2):
     union_length = float(len(union))
     return intersection_length / union_length
 
+# printable runs of 4 or more characters, as found by the 'strings' utility
+STRINGS = re.compile(b"[\x20-\x7e\t]{4,}")
+
+FEATURE_KINDS = ("strings","imports","sections","resources")
+
 def getstrings(fullpath):
     """
     Extract strings from the binary indicated by the 'fullpath'
     parameter, and then return the set of unique strings in
     the binary.
     """
-    strings = os.popen("strings '{0}'".format(fullpath)).read()
-    strings = set(strings.split("\n"))
-    return strings
+    return getfeatures(fullpath,("strings",))
 
 def pecheck(fullpath):
     """
-    Do a cursory sanity check to make sure 'fullpath' is
-    a Windows PE executable (PE executables start with the
-    two bytes 'MZ')
+    Do a sanity check to make sure 'fullpath' is a Windows PE
+    executable: it starts with the two bytes 'MZ', and the header
+    offset at 0x3C points at the signature 'PE\\0\\0' inside the file.
+    """
+    with open(fullpath,"rb") as f:
+        header = f.read(64)
+        if len(header) < 64 or header[:2] != b"MZ":
+            return False
+        f.seek(struct.unpack_from("<I",header,0x3C)[0])
+        return f.read(4) == b"PE\0\0"
+
+class PEFile(object):
+    """
+    Minimal, bounds-checked parser of the PE structures we take features
+    from, working directly on the first 'size' bytes of the sample in
+    memory (a memory-mapped file or a reused decompression buffer): the
+    section table, the import directory and the resource directory.
+    Malformed structures end the parse of that structure early instead
+    of raising.
+    """
+    def __init__(self,data,size=None):
+        self.data = data
+        self.size = len(data) if size is None else size
+        self.sections = []
+        self.import_rva = self.resource_rva = 0
+        self.pe32_plus = False
+        pe = self.u32(0x3C)
+        if self.slice(0,2) != b"MZ" or self.slice(pe,pe+4) != b"PE\0\0":
+            raise ValueError("not a PE file")
+        num_sections,optional_size = self.u16(pe+6),self.u16(pe+20)
+        optional = pe + 24
+        magic = self.u16(optional)
+        self.pe32_plus = magic == 0x20b
+        directories = optional + (112 if self.pe32_plus else 96)
+        num_directories = self.u32(directories - 4)
+        if num_directories > 1:
+            self.import_rva = self.u32(directories + 8)
+        if num_directories > 2:
+            self.resource_rva = self.u32(directories + 16)
+        table = optional + optional_size
+        for k in range(num_sections):
+            entry = table + 40 * k
+            if entry + 40 > self.size:
+                break
+            name = self.slice(entry,entry+8).rstrip(b"\0")
+            virtual_size,virtual_address,raw_size,raw_offset = struct.unpack_from("<IIII",self.data,entry+8)
+            self.sections.append((name,virtual_address,max(virtual_size,raw_size),raw_offset,raw_size))
+
+    def slice(self,start,end):
+        """
+        Return the bytes from 'start' to 'end', cut off at the end of the sample.
+        """
+        return bytes(self.data[max(start,0):min(end,self.size)])
+
+    def u16(self,offset):
+        return struct.unpack_from("<H",self.data,offset)[0] if 0 <= offset <= self.size - 2 else 0
+
+    def u32(self,offset):
+        return struct.unpack_from("<I",self.data,offset)[0] if 0 <= offset <= self.size - 4 else 0
+
+    def u64(self,offset):
+        return struct.unpack_from("<Q",self.data,offset)[0] if 0 <= offset <= self.size - 8 else 0
+
+    def offset(self,rva):
+        """
+        Translate a relative virtual address to a file offset, or -1.
+        """
+        for name,virtual_address,virtual_size,raw_offset,raw_size in self.sections:
+            if virtual_address <= rva < virtual_address + virtual_size:
+                offset = rva - virtual_address + raw_offset
+                return offset if offset < self.size else -1
+        return -1
+
+    def cstring(self,offset,limit=256):
+        """
+        Read a NUL-terminated string of at most 'limit' bytes.
+        """
+        if offset < 0:
+            return b""
+        end = self.data.find(b"\0",offset,min(offset + limit,self.size))
+        return self.slice(offset,end if end >= 0 else offset + limit)
+
+    def imports(self):
+        """
+        Return 'dll!function' (or 'dll!#ordinal') for every imported
+        function, with the DLL name lowercased.
+        """
+        imports = set()
+        descriptor = self.offset(self.import_rva) if self.import_rva else -1
+        while 0 <= descriptor <= self.size - 20 and len(imports) < 65536:
+            lookup_rva,_,_,name_rva,address_rva = struct.unpack_from("<IIIII",self.data,descriptor)
+            if name_rva == 0:
+                break
+            dll = self.cstring(self.offset(name_rva)).lower()
+            thunk = self.offset(lookup_rva or address_rva)
+            size,ordinal_flag = (8,1 << 63) if self.pe32_plus else (4,1 << 31)
+            for k in range(65536):
+                if thunk < 0:
+                    break
+                value = self.u64(thunk + k * size) if self.pe32_plus else self.u32(thunk + k * size)
+                if value == 0:
+                    break
+                if value & ordinal_flag:
+                    imports.add(dll + b"!#" + str(value & 0xFFFF).encode("ascii"))
+                else:
+                    # Skip the 2-byte hint only once the name is known to be in the file.
+                    hint = self.offset(value & 0x7FFFFFFF)
+                    imports.add(dll + (b"!" + self.cstring(hint + 2) if hint >= 0 else b"!?"))
+            descriptor += 20
+        return imports
+
+    def section_hashes(self):
+        """
+        Return 'name:md5' of the raw data of every section.
+        """
+        hashes = set()
+        for name,virtual_address,virtual_size,raw_offset,raw_size in self.sections:
+            raw = self.slice(raw_offset,raw_offset+raw_size)
+            if raw:
+                hashes.add(name + b":" + hashlib.md5(raw).hexdigest().encode("ascii"))
+        return hashes
+
+    def resource_names(self):
+        """
+        Return 'type/name' for every resource, using the string name of
+        each directory entry where there is one and '#id' otherwise.
+        """
+        names = set()
+        base = self.offset(self.resource_rva) if self.resource_rva else -1
+        if base < 0:
+            return names
+
+        def entries(directory):
+            count = self.u16(directory + 12) + self.u16(directory + 14)
+            for k in range(min(count,4096)):
+                name,target = self.u32(directory + 16 + 8 * k),self.u32(directory + 20 + 8 * k)
+                if name & 0x80000000:
+                    string = base + (name & 0x7FFFFFFF)
+                    length = self.u16(string)
+                    label = self.slice(string+2,string+2+2*length).decode("utf-16-le","replace").encode("utf-8")
+                else:
+                    label = b"#" + str(name).encode("ascii")
+                yield label,target
+
+        for type_label,type_target in entries(base):
+            if not type_target & 0x80000000:
+                continue
+            for name_label,name_target in entries(base + (type_target & 0x7FFFFFFF)):
+                names.add(type_label + b"/" + name_label)
+        return names
+
+def getfeatures(fullpath,kinds=("strings",)):
+    """
+    Extract the requested kinds of features (see FEATURE_KINDS) from the
+    binary 'fullpath' in one pass over a memory mapping of the file and
+    return them as a single set (see data_features()).
+    """
+    with open(fullpath,"rb") as f:
+        if os.fstat(f.fileno()).st_size == 0:
+            return set()
+        data = mmap.mmap(f.fileno(),0,access=mmap.ACCESS_READ)
+    try:
+        return data_features(data,len(data),kinds)
+    finally:
+        data.close()
+
+def data_features(data,size,kinds=("strings",)):
+    """
+    Extract the requested kinds of features (see FEATURE_KINDS) from the
+    first 'size' bytes of a sample already in memory and return them as
+    a single set. Strings are kept as they are, the other kinds are
+    prefixed with their kind ('imports:kernel32.dll!Sleep',
+    'sections:.text:<md5>', 'resources:#16/#1') so that they never
+    collide with each other or with a string.
+    """
+    features = set()
+    if "strings" in kinds:
+        features.update(bytes(match.group()) for match in STRINGS.finditer(data,0,size))
+    if any(kind in kinds for kind in FEATURE_KINDS[1:]):
+        try:
+            pe = PEFile(data,size)
+        except (ValueError,struct.error):
+            return features
+        if "imports" in kinds:
+            features.update(b"imports:" + name for name in pe.imports())
+        if "sections" in kinds:
+            features.update(b"sections:" + name for name in pe.section_hashes())
+        if "resources" in kinds:
+            features.update(b"resources:" + name for name in pe.resource_names())
+    return features
+
+def data_pecheck(data,size):
+    """
+    pecheck() for the first 'size' bytes of a sample already in memory.
+    """
+    if size < 64 or bytes(data[:2]) != b"MZ":
+        return False
+    pe = struct.unpack_from("<I",data,0x3C)[0]
+    return pe + 4 <= size and bytes(data[pe:pe+4]) == b"PE\0\0"
+
+def read_into(stream,size,buffer):
+    """
+    Read 'size' bytes from 'stream' into the reusable bytearray 'buffer',
+    growing it if needed but never shrinking it, so a whole archive is
+    decompressed through a single allocation. Return the bytes read.
+    """
+    if len(buffer) < size:
+        buffer.extend(b"\0" * (size - len(buffer)))
+    view = memoryview(buffer)
+    done = 0
+    while done < size:
+        if hasattr(stream,"readinto"):
+            count = stream.readinto(view[done:size])
+        else:
+            chunk = stream.read(min(size - done,1 << 20))
+            count = len(chunk)
+            view[done:done+count] = chunk
+        if not count:
+            break
+        done += count
+    return done
+
+def sample_source(target):
+    """
+    Tell what kind of sample source 'target' is: "directory", "zip",
+    "tar" (uncompressed, so members can be read by offset) or "stream"
+    (a compressed tar archive, which can only be read in order).
+    """
+    if os.path.isdir(target):
+        return "directory"
+    if zipfile.is_zipfile(target):
+        return "zip"
+    if tarfile.is_tarfile(target):
+        try:
+            tarfile.open(target,"r:").close()
+            return "tar"
+        except tarfile.ReadError:
+            return "stream"
+    raise ValueError("{0} is neither a directory nor a zip or tar archive".format(target))
+
+def sample_locators(target,source):
+    """
+    List the samples of 'target' as (sample, locator) pairs. A sample is
+    named by its path; archive members are named as if the archive were
+    a directory ('archive.zip/dir/member'). The locator is the file path
+    of a directory sample, the member name of a zip member and the
+    (data offset, size) of a tar member. Zip and tar members are sorted
+    by their offset in the archive, so that reading them in order reads
+    the archive front to back.
+    """
+    if source == "directory":
+        locators = []
+        for root, dirs, paths in os.walk(target):
+            for path in paths:
+                full_path = os.path.join(root,path)
+                locators.append((full_path,full_path))
+        return locators
+    if source == "zip":
+        with zipfile.ZipFile(target) as archive:
+            members = sorted((info.header_offset,info.filename) for info in archive.infolist()
+                             if not info.filename.endswith("/"))
+        return [(os.path.join(target,name),name) for offset,name in members]
+    with tarfile.open(target) as archive:
+        return [(os.path.join(target,info.name),(info.offset_data,info.size))
+                for info in archive if info.isfile()]
+
+def scan_sample(sample,data,size,kinds,known,keep_strings):
+    """
+    Check one sample in memory and extract its features. Return None if
+    it is not a PE file, (sample, sha256, None, None, 0) if its digest
+    is in 'known', and (sample, sha256, hashes, strings, number of
+    features) otherwise, where the strings (kept only if
+    'keep_strings') are in the order of their hashes.
+    """
+    if not data_pecheck(data,size):
+        return None
+    sha256 = hashlib.sha256(data if size == len(data) else memoryview(data)[:size]).hexdigest()
+    if sha256 in known:
+        return sample,sha256,None,None,0
+    attributes = data_features(data,size,kinds)
+    if keep_strings:
+        hashes,strings = hash_strings(attributes,return_strings=True)
+    else:
+        hashes,strings = hash_strings(attributes),None
+    return sample,sha256,hashes,strings,len(attributes)
+
+def scan_chunk(task):
+    """
+    Worker for scan_samples(): scan a run of samples of one source,
+    reading archive members in archive order through one reused buffer.
+    """
+    target,source,chunk,kinds,known,keep_strings = task
+    results = []
+    buffer = bytearray()
+    if source == "directory":
+        for sample,path in chunk:
+            with open(path,"rb") as f:
+                size = os.fstat(f.fileno()).st_size
+                if size == 0:
+                    continue
+                data = mmap.mmap(f.fileno(),0,access=mmap.ACCESS_READ)
+            try:
+                results.append(scan_sample(sample,data,size,kinds,known,keep_strings))
+            finally:
+                data.close()
+    elif source == "zip":
+        with zipfile.ZipFile(target) as archive:
+            for sample,name in chunk:
+                stream = archive.open(name)
+                size = read_into(stream,archive.getinfo(name).file_size,buffer)
+                stream.close()
+                results.append(scan_sample(sample,buffer,size,kinds,known,keep_strings))
+    else:
+        with open(target,"rb") as f:
+            for sample,(offset,size) in chunk:
+                f.seek(offset)
+                size = read_into(f,size,buffer)
+                results.append(scan_sample(sample,buffer,size,kinds,known,keep_strings))
+    return [result for result in results if result is not None]
+
+def scan_samples(target,kinds,known=frozenset(),processes=1,chunk_size=64,keep_strings=False):
+    """
+    Generate (sample, sha256, hashes, strings, number of features), as
+    returned by scan_sample(), for every PE
+    sample in 'target': a directory tree, or a zip or tar archive whose
+    members are read directly, without extracting them to disk, each
+    decompressed once into a reused buffer. Samples whose SHA-256 is in
+    'known' are not extracted (hashes is None). Runs of 'chunk_size'
+    samples, consecutive in the archive, are scanned in parallel on
+    'processes' worker processes; results come out in archive order.
+    A compressed tar archive can only be read front to back, so its
+    members are scanned one after the other.
+    """
+    source = sample_source(target)
+    if source == "stream":
+        buffer = bytearray()
+        with tarfile.open(target) as archive:
+            for info in archive:
+                if info.isfile():
+                    size = read_into(archive.extractfile(info),info.size,buffer)
+                    result = scan_sample(os.path.join(target,info.name),buffer,size,kinds,known,keep_strings)
+                    if result is not None:
+                        yield result
+        return
+
+    locators = sample_locators(target,source)
+    tasks = [(target,source,locators[start:start+chunk_size],kinds,known,keep_strings)
+             for start in range(0,len(locators),chunk_size)]
+    if processes > 1 and len(tasks) > 1:
+        pool = multiprocessing.Pool(processes)
+        try:
+            for results in pool.imap(scan_chunk,tasks):
+                for result in results:
+                    yield result
+        finally:
+            pool.terminate()
+    else:
+        for task in tasks:
+            for result in scan_chunk(task):
+                yield result
+
+def build_inverted_index(malware_paths,malware_attributes,max_df):
+    """
+    Build the global string -> posting list inverted index over all
+    samples, whose attributes are sorted arrays of string IDs (see
+    StringDictionary). A posting list holds the indices (into
+    'malware_paths') of the samples containing the string, in
+    increasing order.
+
+    Strings found in more than 'max_df' of the samples (a fraction
+    of the corpus when <= 1, an absolute sample count otherwise) are
+    stop strings: they make every pair look related and have the
+    longest posting lists, so they are dropped from the index and
+    from every sample's feature array. Return the posting lists, the
+    per-sample feature arrays and the array of stop string IDs.
+    """
+    attributes = [malware_attributes[path] for path in malware_paths]
+    all_ids = np.concatenate(attributes) if attributes else np.zeros(0,dtype=np.uint32)
+    document_frequency = np.bincount(all_ids) if len(all_ids) else np.zeros(0,dtype=np.intp)
+
+    if max_df <= 1.0:
+        cutoff = max_df * len(malware_paths)
+    else:
+        cutoff = max_df
+    stop = document_frequency > cutoff
+    features = [ids[~stop[ids]] for ids in attributes]
+
+    # group the (string, sample) pairs by string with a stable sort, so
+    # every posting list comes out in increasing sample order
+    strings = np.concatenate(features) if features else np.zeros(0,dtype=np.uint32)
+    samples = np.repeat(np.arange(len(features)),[len(ids) for ids in features])
+    order = np.argsort(strings,kind="mergesort")
+    strings,samples = strings[order],samples[order]
+    vocabulary,starts = np.unique(strings,return_index=True)
+    postings = dict(zip(vocabulary.tolist(),[posting.tolist() for posting in np.split(samples,starts[1:])]
+                        if len(vocabulary) else []))
+    return postings,features,np.nonzero(stop)[0]
+
+def idf_weights(postings,num_samples):
+    """
+    Weight every indexed string by its smoothed inverse document
+    frequency, log((1 + N) / (1 + df)) + 1, so that rare strings count
+    for more than common ones but every weight stays positive. Return
+    the weights as an array indexed by string ID.
+    """
+    weights = np.zeros(max(postings) + 1 if postings else 0)
+    for string,posting in postings.items():
+        weights[string] = math.log((1.0 + num_samples) / (1.0 + len(posting))) + 1.0
+    return weights
+
+def sample_totals(features,weights=None):
+    """
+    Return the size (unweighted) or the total weight of every sample.
+    """
+    if weights is None:
+        return [len(strings) for strings in features]
+    return [float(weights[strings].sum()) for strings in features]
+
+def candidate_pairs(postings,features,rows=None,weights=None,columns=0):
+    """
+    Generate every pair of samples (i, j), i < j, that shares at least
+    one indexed string, together with the size of their intersection.
+    For each sample i we walk the tails (j > i) of the posting lists of
+    its strings and count hits per j, so candidate generation and the
+    intersection counts come out of a single pass over the posting
+    lists, and pairs with nothing in common are never touched.
+
+    Only the first 'rows' samples (all of them by default) are scanned,
+    so putting the new samples first restricts the comparison to the
+    pairs involving at least one new sample. Likewise only the samples
+    j >= 'columns' are paired, so two blocks laid out one after the
+    other with rows = columns = the size of the first give exactly the
+    pairs across the blocks. With 'weights', the intersection is the
+    total weight of the shared strings instead.
+    """
+    if rows is None:
+        rows = len(features)
+    if weights is not None:
+        weights = weights.tolist()
+    for i in range(rows):
+        strings = features[i].tolist()
+        counts = collections.defaultdict(int)
+        for string in strings:
+            posting = postings[string]
+            hit = 1 if weights is None else weights[string]
+            for j in posting[bisect.bisect_right(posting,max(i,columns - 1)):]:
+                counts[j] += hit
+        for j in sorted(counts):
+            yield i,j,counts[j]
+
+def candidate_similarities(postings,features,rows=None,weights=None,columns=0):
+    """
+    Generate (i, j, jaccard) for every candidate pair from
+    candidate_pairs() (see there for 'rows' and 'columns'), computing the Jaccard index from the
+    intersection count and the two set sizes. With 'weights' this is
+    the weighted Jaccard index: the weight of the intersection over
+    the weight of the union.
+    """
+    totals = sample_totals(features,weights)
+    for i,j,intersection_length in candidate_pairs(postings,features,rows,weights,columns):
+        union_length = totals[i] + totals[j] - intersection_length
+        yield i,j,float(intersection_length) / union_length
+
+def weighted_jaccard(hashes1,weights1,hashes2,weights2):
+    """
+    Compute the weighted Jaccard index sum(min(w1, w2)) / sum(max(w1, w2))
+    of two weighted sets, each given as a sorted array of unique hashes
+    and the matching array of weights (an absent element weighs 0).
+    """
+    common,index1,index2 = np.intersect1d(hashes1,hashes2,assume_unique=True,return_indices=True)
+    minimum = np.minimum(weights1[index1],weights2[index2]).sum()
+    maximum = weights1.sum() + weights2.sum() - minimum
+    return float(minimum / maximum) if maximum > 0 else 0.0
+
+def icws_sketch(hashes,weights,sketch_size):
+    """
+    Compute the improved consistent weighted sampling (ICWS, Ioffe 2010)
+    sketch of a weighted set. For each of 'sketch_size' seeded hash
+    functions, every element s of weight w draws r, c ~ Gamma(2, 1) and
+    beta ~ U(0, 1) from its hash, gets t = floor(ln(w) / r + beta) and
+    a = c / exp(r (t - beta + 1)), and the sample is the (s, t) of
+    smallest a, folded into one uint64. The fraction of positions where
+    two sketches agree estimates the weighted Jaccard index. Elements
+    of weight 0 are ignored; an empty set gets an all-zero sketch.
     """
-    return open(fullpath).read(2) == "MZ"
+    seeds = mix64(np.arange(1,sketch_size+1,dtype=np.uint64) + np.uint64(0x5EED))
+    best = np.full(sketch_size,np.inf)
+    sketch = np.zeros(sketch_size,dtype=np.uint64)
+    keep = weights > 0
+    hashes,log_weights = hashes[keep],np.log(weights[keep])
+
+    def uniform(h,salt):
+        # uniform in (0, 1) from the top 53 bits of a salted hash
+        return ((mix64(h ^ np.uint64(salt)) >> np.uint64(11)).astype(np.float64) + 0.5) / float(1 << 53)
+
+    # process the elements in chunks to bound the sketch_size x chunk temporaries
+    for start in range(0,len(hashes),4096):
+        chunk = hashes[start:start+4096]
+        h = mix64(chunk[np.newaxis,:] ^ seeds[:,np.newaxis])
+        r = -np.log(uniform(h,1) * uniform(h,2))
+        c = -np.log(uniform(h,3) * uniform(h,4))
+        beta = uniform(h,5)
+        t = np.floor(log_weights[start:start+4096][np.newaxis,:] / r + beta)
+        a = c / np.exp(r * (t - beta + 1))
+        column = a.argmin(axis=1)
+        rows = np.arange(sketch_size)
+        better = a[rows,column] < best
+        best[better] = a[rows,column][better]
+        samples = mix64(chunk[column] ^ mix64(t[rows,column].astype(np.int64).view(np.uint64)))
+        sketch[better] = samples[better]
+    return sketch
+
+def lsh_candidates(sketches,bands,rows=None):
+    """
+    Generate the candidate pairs (i, j), i < j, of locality-sensitive
+    hashing over sketches (one row per sample): the sketch is cut into
+    'bands' bands and two samples are candidates if they agree on all
+    positions of at least one band. Pairs of similarity s are found
+    with probability 1 - (1 - s^r)^bands for r positions per band. As
+    in candidate_pairs(), only the first 'rows' samples are scanned.
+    """
+    n,size = sketches.shape
+    width = size // bands
+    keys = [[sketches[i,band*width:(band+1)*width].tobytes() for band in range(bands)] for i in range(n)]
+    buckets = [collections.defaultdict(list) for band in range(bands)]
+    for i in range(n):
+        for band in range(bands):
+            buckets[band][keys[i][band]].append(i)
+
+    if rows is None:
+        rows = n
+    for i in range(rows):
+        candidates = set()
+        for band in range(bands):
+            candidates.update(j for j in buckets[band][keys[i][band]] if j > i)
+        for j in sorted(candidates):
+            yield i,j
+
+def sketch_similarities(features,sketch_size,bands,rows=None,weights=None):
+    """
+    Generate (i, j, jaccard) for the candidate pairs of LSH over the
+    ICWS sketches of the samples (unit weights unless 'weights' are
+    given), verifying each candidate with the exact (weighted) Jaccard
+    index computed on the samples' sorted weighted hash arrays.
+    """
+    hashes = [strings.astype(np.uint64) for strings in features]
+    if weights is None:
+        sample_weights = [np.ones(len(h)) for h in hashes]
+    else:
+        sample_weights = [weights[strings] for strings in features]
+    sketches = np.array([icws_sketch(h,w,sketch_size) for h,w in zip(hashes,sample_weights)]).reshape(-1,sketch_size)
+    for i,j in lsh_candidates(sketches,bands,rows):
+        yield i,j,weighted_jaccard(hashes[i],sample_weights[i],hashes[j],sample_weights[j])
+
+SIMHASH_BITS = 64
+
+def simhash(strings):
+    """
+    Compute the 64-bit SimHash fingerprint of a set of string IDs: each
+    ID is hashed with mix64() and bit b is set if more than half of the
+    hashes have bit b set. Sets that differ in a few strings get
+    fingerprints that differ in a few bits, so near-duplicate samples
+    are close in Hamming distance.
+    """
+    hashes = mix64(np.asarray(strings,dtype=np.uint64))
+    shifts = np.arange(SIMHASH_BITS,dtype=np.uint64)
+    counts = np.zeros(SIMHASH_BITS,dtype=np.int64)
+    for start in range(0,len(hashes),4096):
+        bits = (hashes[start:start+4096,None] >> shifts) & np.uint64(1)
+        counts += bits.sum(axis=0).astype(np.int64)
+    return sum(1 << int(bit) for bit in np.nonzero(2 * counts > len(hashes))[0])
+
+def hamming_distance(x,y):
+    return bin(x ^ y).count("1")
+
+class SimHashIndex(object):
+    """
+    Index of SimHash fingerprints answering 'which fingerprint is within
+    max_distance bits of this one'. The 64 bits are cut into
+    max_distance + 1 blocks; two fingerprints at most max_distance bits
+    apart agree on at least one whole block, so one table per block,
+    keyed by the fingerprint permuted to put that block in front (its
+    prefix, here simply the masked block), finds every match with
+    max_distance + 1 exact lookups instead of a scan.
+    """
+    def __init__(self,max_distance):
+        blocks = min(max_distance,SIMHASH_BITS - 1) + 1
+        bounds = [SIMHASH_BITS * block // blocks for block in range(blocks + 1)]
+        self.max_distance = max_distance
+        self.masks = [((1 << (end - start)) - 1) << start for start,end in zip(bounds,bounds[1:])]
+        self.tables = [collections.defaultdict(list) for mask in self.masks]
+        self.fingerprints = []
+
+    def add(self,fingerprint):
+        """
+        Add a fingerprint and return its id, the number of fingerprints
+        added before it.
+        """
+        for mask,table in zip(self.masks,self.tables):
+            table[fingerprint & mask].append(len(self.fingerprints))
+        self.fingerprints.append(fingerprint)
+        return len(self.fingerprints) - 1
+
+    def query(self,fingerprint):
+        """
+        Return the id of the closest fingerprint within max_distance
+        bits (the oldest among equals), or None.
+        """
+        best = None
+        for mask,table in zip(self.masks,self.tables):
+            for id in table.get(fingerprint & mask,()):
+                distance = hamming_distance(fingerprint,self.fingerprints[id])
+                if distance <= self.max_distance and (best is None or (distance,id) < best):
+                    best = distance,id
+        return None if best is None else best[1]
+
+def collapse_near_duplicates(features,max_distance):
+    """
+    Group the samples whose SimHash is within 'max_distance' bits of an
+    earlier group's representative (its first sample). Return the
+    representatives, in increasing order, and the groups, each a list of
+    sample indices headed by its representative.
+    """
+    index = SimHashIndex(max_distance)
+    representatives = []
+    groups = []
+    for i,strings in enumerate(features):
+        fingerprint = simhash(strings)
+        group = index.query(fingerprint)
+        if group is None:
+            index.add(fingerprint)
+            representatives.append(i)
+            groups.append([i])
+        else:
+            groups[group].append(i)
+    return representatives,groups
+
+def representative_index(features,representatives):
+    """
+    Restrict the posting lists and feature lists to the representatives,
+    renumbered 0 .. len(representatives) - 1.
+    """
+    postings = collections.defaultdict(list)
+    representative_features = []
+    for r,i in enumerate(representatives):
+        for string in features[i]:
+            postings[string].append(r)
+        representative_features.append(features[i])
+    return postings,representative_features
+
+def group_similarity(features,weights=None):
+    """
+    Return a function giving the exact (weighted) Jaccard index of two
+    samples, caching the string sets it builds.
+    """
+    sets = dict()
+    def similarity(i,j):
+        for k in (i,j):
+            if k not in sets:
+                sets[k] = set(features[k].tolist())
+        intersection = sets[i] & sets[j]
+        union = sets[i] | sets[j]
+        if weights is None:
+            return float(len(intersection)) / len(union) if union else 0.0
+        return float(weights[list(intersection)].sum() / weights[list(union)].sum())
+    return similarity
+
+def expand_similarities(similarities,groups,features,threshold,rows=None,weights=None):
+    """
+    Expand (a, b, jaccard) over representatives back to the samples of
+    their groups: every pair of samples of a group, and every pair of
+    members of two groups whose representatives are above 'threshold',
+    gets its exact (weighted) Jaccard index. Near-duplicates collapsed
+    away are assumed to be close to their representative, so pairs of
+    groups whose representatives are below the threshold are not
+    expanded. With 'rows', pairs of samples both at or after 'rows' are
+    skipped, as in candidate_pairs().
+    """
+    similarity = group_similarity(features,weights)
+
+    def scanned(i,j):
+        return rows is None or min(i,j) < rows
+
+    for group in groups:
+        for i,j in itertools.combinations(group,2):
+            if scanned(i,j):
+                yield i,j,similarity(i,j)
+    for a,b,jaccard_index in similarities:
+        if jaccard_index <= threshold:
+            continue
+        for i in groups[a]:
+            for j in groups[b]:
+                if not scanned(i,j):
+                    continue
+                if i == groups[a][0] and j == groups[b][0]:
+                    yield i,j,jaccard_index
+                else:
+                    yield min(i,j),max(i,j),similarity(i,j)
+
+def link_representatives(similarities,groups,features,threshold,rows=None,weights=None):
+    """
+    Link the samples of each group to the edges of (a, b, jaccard) over
+    representatives without expanding them, in time linear in the group
+    sizes: every member gets its exact (weighted) Jaccard index to its
+    own representative, and to the other representative of each edge
+    above 'threshold' its group takes part in. Pairs of members, within
+    a group or across two groups, are not compared, so this is a reduced
+    edge set rather than the edges expand_similarities() finds; members
+    are only connected through their representatives. With 'rows',
+    pairs of samples both at or after 'rows' are skipped.
+    """
+    similarity = group_similarity(features,weights)
+
+    def scanned(i,j):
+        return rows is None or min(i,j) < rows
+
+    for group in groups:
+        for i in group[1:]:
+            if scanned(group[0],i):
+                yield group[0],i,similarity(group[0],i)
+    for a,b,jaccard_index in similarities:
+        if jaccard_index <= threshold:
+            continue
+        if scanned(groups[a][0],groups[b][0]):
+            yield groups[a][0],groups[b][0],jaccard_index
+        for member,representative in [(i,groups[b][0]) for i in groups[a][1:]] + \
+                                     [(j,groups[a][0]) for j in groups[b][1:]]:
+            if scanned(member,representative):
+                yield min(member,representative),max(member,representative),similarity(member,representative)
+
+def jaccard_matrix(postings,features,block_size=1024,threads=1,weights=None):
+    """
+    Compute the dense N x N matrix of the Jaccard indices of all pairs
+    of samples. With X the sparse binary sample x string incidence
+    matrix (CSR, one row per sample), the intersection sizes are
+    X . X^T, which we compute a block of 'block_size' samples at a time
+    as the sparse product X[a:a+block_size] . X[a:]^T (upper triangle
+    only), on 'threads' threads. Each block is turned into Jaccard
+    indices in place and written, with its mirror image, straight into
+    the result, so the only N x N array is the result itself. The work
+    follows the number of strings the samples share instead of N^2
+    times the vocabulary, and the counts are exact. With 'weights', X
+    holds the square roots of the string weights, which gives the
+    weighted Jaccard indices instead.
+    """
+    n = len(features)
+    sizes = np.array(sample_totals(features,weights),dtype=np.float64)
+    matrix = np.empty((n,n),dtype=np.float64)
+    indptr = np.concatenate(([0],np.cumsum([len(strings) for strings in features]))).astype(np.int64)
+    indices = np.concatenate(features).astype(np.int64) if n else np.zeros(0,dtype=np.int64)
+    data = np.ones(len(indices)) if weights is None else np.sqrt(weights[indices])
+    width = int(indices.max()) + 1 if len(indices) else 0
+    x = scipy.sparse.csr_matrix((data,indices,indptr),shape=(n,width))
+    xt = x.T.tocsc()
+
+    def multiply_block(a):
+        # the blocks write disjoint rows and columns of the result
+        block = x[a:a+block_size].dot(xt[:,a:]).toarray()
+        unions = sizes[a:a+block_size,np.newaxis] + sizes[np.newaxis,a:]
+        unions -= block
+        np.divide(block,unions,out=block,where=unions > 0)
+        block[unions <= 0] = 1.0
+        matrix[a:a+block_size,a:] = block
+        matrix[a:,a:a+block_size] = block.T
+
+    if threads > 1:
+        pool = ThreadPool(threads)
+        pool.map(multiply_block,range(0,n,block_size))
+        pool.close()
+    else:
+        for a in range(0,n,block_size):
+            multiply_block(a)
+
+    np.fill_diagonal(matrix,1.0)
+    return matrix
+
+def matrix_similarities(matrix,threshold,rows=None):
+    """
+    Generate (i, j, jaccard) for every pair i < j of the Jaccard matrix
+    above 'threshold', scanning only the first 'rows' rows if given.
+    """
+    if rows is None:
+        rows = len(matrix)
+    for i in range(rows):
+        for j in np.nonzero(matrix[i,i+1:] > threshold)[0]:
+            yield i,i+1+int(j),float(matrix[i,i+1+j])
+
+def sample_label(path):
+    """
+    Short name of a sample for tables: the hash at the end of its file name.
+    """
+    return os.path.split(path)[-1].split("_")[-1]
+
+def write_matrix(matrix,malware_paths,matrix_path,csv_path=None):
+    """
+    Save the Jaccard matrix in NumPy's binary .npy format, with the
+    sample paths in row order, one per line, in 'matrix_path'.nodes.
+    Optionally also export it as a CSV table like jaccard_table.csv.
+    """
+    np.save(matrix_path,matrix)
+    with open(matrix_path + ".nodes","w") as f:
+        for path in malware_paths:
+            f.write(path + "\n")
+    if csv_path is not None:
+        labels = [sample_label(path) for path in malware_paths]
+        with open(csv_path,"w") as f:
+            f.write(",".join(["jaccard_index"] + labels) + "\n")
+            for label,row in zip(labels,matrix):
+                f.write(",".join([label] + [str(value) for value in row.tolist()]) + "\n")
+
+class UnionFind(object):
+    """
+    Disjoint-set forest over the integers 0 .. n-1 with path compression
+    (path halving) and union by rank, so each find/union takes
+    effectively constant time.
+    """
+    def __init__(self,n):
+        self.parent = list(range(n))
+        self.rank = [0] * n
+
+    def add(self):
+        """
+        Add a new singleton set and return its element.
+        """
+        self.parent.append(len(self.parent))
+        self.rank.append(0)
+        return len(self.parent) - 1
+
+    def find(self,x):
+        parent = self.parent
+        while parent[x] != x:
+            parent[x] = parent[parent[x]]
+            x = parent[x]
+        return x
+
+    def union(self,x,y):
+        x,y = self.find(x),self.find(y)
+        if x == y:
+            return x
+        if self.rank[x] < self.rank[y]:
+            x,y = y,x
+        self.parent[y] = x
+        if self.rank[x] == self.rank[y]:
+            self.rank[x] += 1
+        return x
+
+def average_linkage(edges,threshold):
+    """
+    Split one connected component into average-linkage clusters. 'edges'
+    are its (i, j, jaccard) edges; pairs without an edge count as
+    similarity 0. Starting from singletons, repeatedly merge the two
+    clusters with the highest average pairwise similarity while it stays
+    above 'threshold'. Return a dict sample -> cluster representative.
+    """
+    size = dict()
+    links = collections.defaultdict(dict) # cluster -> {cluster: summed similarity}
+    for i,j,jaccard_index in edges:
+        size[i] = size[j] = 1
+        links[i][j] = links[j][i] = links[i].get(j,0.0) + jaccard_index
+    members = dict((i,[i]) for i in size)
+
+    while True:
+        best,best_pair = threshold,None
+        for a in links:
+            for b,total in links[a].items():
+                average = total / (size[a] * size[b])
+                if average > best:
+                    best,best_pair = average,(a,b)
+        if best_pair is None:
+            break
+
+        # merge cluster b into cluster a
+        a,b = best_pair
+        size[a] += size.pop(b)
+        members[a].extend(members.pop(b))
+        for c,total in links.pop(b).items():
+            del links[c][b]
+            if c != a:
+                links[a][c] = links[c][a] = links[a].get(c,0.0) + total
+
+    return dict((i,a) for a in members for i in members[a])
+
+class FamilyWriter(object):
+    """
+    Cluster the samples into families as edges are emitted: a union-find
+    over the samples keeps the connected components of the similarity
+    graph in constant time per edge, without holding the graph. With
+    'refine', the edges are also kept so that each component can be
+    split into average-linkage clusters at the end. close() writes a
+    'path,family' CSV line per sample; family ids are numbered in the
+    order of their first sample.
+    """
+    def __init__(self,path,threshold,refine=False):
+        self.path = path
+        self.threshold = threshold
+        self.ids = dict()
+        self.paths = []
+        self.components = UnionFind(0)
+        self.edges = [] if refine else None
+
+    def node(self,path):
+        if path not in self.ids:
+            self.ids[path] = self.components.add()
+            self.paths.append(path)
+
+    def edge(self,malware1,malware2,jaccard_index):
+        self.node(malware1)
+        self.node(malware2)
+        i,j = self.ids[malware1],self.ids[malware2]
+        self.components.union(i,j)
+        if self.edges is not None:
+            self.edges.append((i,j,jaccard_index))
+
+    def families(self):
+        """
+        Return the family representative of every sample, in sample order.
+        """
+        roots = [self.components.find(i) for i in range(len(self.paths))]
+        if self.edges is None:
+            return roots
+        component_edges = collections.defaultdict(list)
+        for edge in self.edges:
+            component_edges[roots[edge[0]]].append(edge)
+        refined = dict()
+        for edges in component_edges.values():
+            refined.update(average_linkage(edges,self.threshold))
+        return [refined.get(i,i) for i in range(len(self.paths))]
+
+    def close(self):
+        family_ids = dict()
+        with open(self.path,"w") as f:
+            for path,family in zip(self.paths,self.families()):
+                family_id = family_ids.setdefault(family,len(family_ids))
+                f.write("{0},{1}\n".format(csv_field(path),family_id))
+        print "Clustered {0} samples into {1} families ...".format(len(self.paths),len(family_ids))
+
+def hash_strings(strings,return_strings=False):
+    """
+    Hash each string to 64 bits (the first 8 bytes of its MD5 digest)
+    and return the sorted, de-duplicated hashes as a uint64 array, and
+    with 'return_strings' also the list of the strings in the same
+    order. Collisions are negligible at 64 bits, so Jaccard indices
+    over the hashed sets are the ones over the strings themselves.
+    """
+    strings = list(strings)
+    hashes = [struct.unpack("<Q",hashlib.md5(string).digest()[:8])[0] for string in strings]
+    hashes,first = np.unique(np.array(hashes,dtype=np.uint64),return_index=True)
+    if return_strings:
+        return hashes,[strings[index] for index in first.tolist()]
+    return hashes
+
+def mix64(x):
+    """
+    The splitmix64 finalizer, applied elementwise to a uint64 array.
+    Multiplications wrap around modulo 2^64, which is what we want.
+    """
+    x = x ^ (x >> np.uint64(30))
+    x = x * np.uint64(0xBF58476D1CE4E5B9)
+    x = x ^ (x >> np.uint64(27))
+    x = x * np.uint64(0x94D049BB133111EB)
+    return x ^ (x >> np.uint64(31))
+
+def minhash_signature(hashes,num_perm):
+    """
+    Compute the MinHash signature of a set of 64-bit string hashes:
+    for each of 'num_perm' seeded hash functions, the minimum of
+    mix64(hash ^ seed) over the set. The fraction of positions where
+    two signatures agree estimates the Jaccard index of the two sets.
+    An empty set gets all-ones (the maximum value) in every position.
+    """
+    seeds = mix64(np.arange(1,num_perm+1,dtype=np.uint64))
+    signature = np.empty(num_perm,dtype=np.uint64)
+    signature.fill(np.iinfo(np.uint64).max)
+    # process the hashes in chunks to bound the num_perm x chunk temporary
+    for start in range(0,len(hashes),4096):
+        chunk = hashes[start:start+4096]
+        signature = np.minimum(signature,mix64(chunk[np.newaxis,:] ^ seeds[:,np.newaxis]).min(axis=1))
+    return signature
+
+MINHASH_SCHEMES = ("independent","oph")
+
+def oph_signature(hashes,num_perm,max_probes=64):
+    """
+    Compute a MinHash signature of a set of 64-bit string hashes by
+    one-permutation hashing: every hash is mixed once with mix64() and
+    the mixed values are split into 'num_perm' bins by value modulo
+    num_perm, each bin keeping its minimum. That is O(|S| + num_perm)
+    instead of O(num_perm * |S|) for minhash_signature().
+
+    Bins left empty (sets smaller than a few times num_perm) are filled
+    by optimal densification: empty bin i probes the bins
+    mix64(seed_i ^ attempt) modulo num_perm, attempt = 1, 2, ..., and
+    copies the value of the first non-empty one. The probe sequence
+    depends only on i, so two signatures agree in a densified bin with
+    the same probability as in a filled one and the fraction of
+    agreeing positions still estimates the Jaccard index. An empty set
+    gets all-ones (the maximum value) in every position.
+    """
+    maximum = np.iinfo(np.uint64).max
+    signature = np.empty(num_perm,dtype=np.uint64)
+    signature.fill(maximum)
+    if len(hashes) == 0:
+        return signature
+    values = mix64(np.asarray(hashes,dtype=np.uint64))
+    bins = (values % np.uint64(num_perm)).astype(np.intp)
+    # keep the quotient, whose low bits (unlike those of the value) do not
+    # depend on the bin, so b-bit signatures stay meaningful
+    np.minimum.at(signature,bins,values // np.uint64(num_perm))
+
+    filled = np.zeros(num_perm,dtype=bool)
+    filled[bins] = True
+    empty = np.nonzero(~filled)[0]
+    source = np.empty(len(empty),dtype=np.intp)
+    pending = np.ones(len(empty),dtype=bool)
+    seeds = mix64(empty.astype(np.uint64) + np.uint64(num_perm))
+    for attempt in range(1,max_probes + 1):
+        if not pending.any():
+            break
+        probes = (mix64(seeds[pending] ^ np.uint64(attempt)) % np.uint64(num_perm)).astype(np.intp)
+        found = filled[probes]
+        index = np.nonzero(pending)[0]
+        source[index[found]] = probes[found]
+        pending[index[found]] = False
+    # bins still unfilled after max_probes probes take the next filled bin
+    if pending.any():
+        filled_bins = np.nonzero(filled)[0]
+        after = np.searchsorted(filled_bins,empty[pending]) % len(filled_bins)
+        source[pending] = filled_bins[after]
+    signature[empty] = signature[source]
+    return signature
+
+POPCOUNT8 = np.array([bin(byte).count("1") for byte in range(256)],dtype=np.uint8)
+
+def popcount(words):
+    """
+    Count the set bits of the rows of a uint64 array (over its last axis).
+    """
+    words = np.ascontiguousarray(words,dtype=np.uint64)
+    return POPCOUNT8[words.view(np.uint8)].reshape(words.shape[:-1] + (-1,)).sum(axis=-1,dtype=np.int64)
+
+def bbit_pack(signatures,bits):
+    """
+    Keep the lowest 'bits' bits of every position of the MinHash
+    signatures (one row per sample) and pack them as bit planes: plane l
+    holds bit l of every position, 64 positions to a uint64 word, so a
+    row becomes bits * ceil(num_perm / 64) words instead of num_perm.
+    Positions past num_perm are zero in every row.
+    """
+    n,num_perm = signatures.shape
+    words = (num_perm + 63) // 64
+    planes = np.zeros((n,bits,words * 64),dtype=np.uint8)
+    for bit in range(bits):
+        planes[:,bit,:num_perm] = (signatures >> np.uint64(bit)) & np.uint64(1)
+    return np.packbits(planes,axis=-1).view(np.uint64).reshape(n,bits * words)
+
+def bbit_matches(packed1,packed2,bits,num_perm):
+    """
+    Count the positions where two packed b-bit signatures agree on all
+    'bits' bits: XOR each plane, OR the planes together and popcount
+    the positions that differ. Broadcasts over leading axes, so one
+    signature can be compared with a whole (n, words) array at once.
+    """
+    difference = np.bitwise_xor(packed1,packed2)
+    difference = difference.reshape(difference.shape[:-1] + (bits,-1))
+    return num_perm - popcount(np.bitwise_or.reduce(difference,axis=-2))
+
+def bbit_jaccard(matches,num_perm,bits):
+    """
+    Estimate the Jaccard index from the number of positions where two
+    b-bit signatures agree. Unequal minima still agree on their lowest
+    b bits with probability 2^-b (our hash space is far larger than any
+    set), so the agreement rate P relates to the Jaccard index R as
+    P = R + (1 - R) / 2^b, giving R = (P - 2^-b) / (1 - 2^-b).
+    """
+    chance = 0.5 ** bits
+    agreement = np.asarray(matches,dtype=np.float64) / num_perm
+    return np.clip((agreement - chance) / (1.0 - chance),0.0,1.0)
+
+def file_sha256(fullpath):
+    """
+    Return the hex SHA-256 digest of the file at 'fullpath'.
+    """
+    digest = hashlib.sha256()
+    with open(fullpath,"rb") as f:
+        for block in iter(lambda: f.read(1 << 20),b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+class StringDictionary(object):
+    """
+    Global dictionary of the strings seen in any sample: every distinct
+    string hash gets a dense 32-bit ID in order of first appearance, so
+    a sample's features are a small sorted uint32 array instead of a set
+    of Python objects, and everything downstream works on those IDs.
+
+    With a directory (that of a FeatureStore), the dictionary persists
+    there along with a string arena for reverse lookup in reports:
+
+      dictionary.bin  the uint64 hash of every ID, in ID order
+      strings.bin     the strings of all IDs, back to back
+      strings.idx     the uint64 end offset in strings.bin of every ID
+
+    Strings whose text was not kept (samples added to a store before it
+    had a dictionary) are stored empty. The files are appended to in
+    the order strings.bin, strings.idx, dictionary.bin, and trimmed back
+    to their common length when opened.
+    """
+    def __init__(self,directory=None):
+        self.directory = directory
+        self.ids = dict()
+        self.hashes = []
+        self.files = None
+        if directory is None:
+            return
+        hashes = self._read("dictionary.bin")
+        ends = self._read("strings.idx")
+        count = min(len(hashes),len(ends))
+        self.hashes = hashes[:count].tolist()
+        self.ids = dict((h,id) for id,h in enumerate(self.hashes))
+        self.ends = ends[:count].tolist()
+        for name,size in (("dictionary.bin",count * 8),("strings.idx",count * 8),
+                          ("strings.bin",self.ends[-1] if count else 0)):
+            with open(self._path(name),"ab") as f:
+                f.truncate(size)
+        self.files = [open(self._path(name),"ab") for name in ("strings.bin","strings.idx","dictionary.bin")]
+
+    def _path(self,name):
+        return os.path.join(self.directory,name)
+
+    def _read(self,name):
+        if not os.path.exists(self._path(name)):
+            return np.zeros(0,dtype="<u8")
+        return np.fromfile(self._path(name),dtype="<u8")
+
+    def __len__(self):
+        return len(self.hashes)
+
+    def intern(self,hashes,strings=None):
+        """
+        Map a sample's string hashes to their IDs, giving new IDs to the
+        hashes never seen before (and appending their 'strings', given
+        in the order of the hashes, to the arena). Return the sorted
+        uint32 IDs.
+        """
+        ids = np.empty(len(hashes),dtype=np.uint32)
+        for index,h in enumerate(hashes.tolist()):
+            id = self.ids.get(h)
+            if id is None:
+                id = self.ids[h] = len(self.hashes)
+                self.hashes.append(h)
+                if self.files is not None:
+                    text = strings[index] if strings is not None else b""
+                    self.ends.append((self.ends[-1] if self.ends else 0) + len(text))
+                    self.files[0].write(text)
+                    self.files[1].write(struct.pack("<Q",self.ends[-1]))
+                    self.files[2].write(struct.pack("<Q",h))
+            ids[index] = id
+        ids.sort()
+        return ids
+
+    def string(self,id):
+        """
+        Return the string of an ID from the arena, or None without one.
+        """
+        if self.files is None:
+            return None
+        self.flush()
+        start = self.ends[id - 1] if id else 0
+        with open(self._path("strings.bin"),"rb") as f:
+            f.seek(start)
+            return f.read(self.ends[id] - start)
+
+    def flush(self):
+        for f in self.files or ():
+            f.flush()
+
+    def close(self):
+        for f in self.files or ():
+            f.close()
+        self.files = None
+
+class FeatureStore(object):
+    """
+    Persistent on-disk store of per-sample features keyed by the
+    SHA-256 of the sample file, kept in a directory:
+
+      store.json   store parameters (number of MinHash permutations, their
+                   scheme, bits kept per permutation and the kinds of
+                   features extracted)
+      samples.tsv  one line per sample: sha256, path, offset, count
+      hashes.bin   the sorted uint64 string hashes of every sample,
+                   back to back; a sample owns hashes[offset:offset+count]
+      minhash.bin  one uint64 MinHash signature per sample, in the
+                   order of samples.tsv, or with 'minhash_bits' > 0 its
+                   b-bit version packed by bbit_pack()
+      edges.csv    similarity edges found so far, as written by EdgeWriter
+
+    plus the files of its StringDictionary.
+
+    All files are only ever appended to, and samples.tsv is written
+    last, so an interrupted run leaves at most some unreferenced bytes.
+    """
+    def __init__(self,directory,num_perm,kinds=("strings",),minhash_bits=0,scheme="oph"):
+        self.directory = directory
+        if not os.path.isdir(directory):
+            os.makedirs(directory)
+        if os.path.exists(self._path("store.json")):
+            with open(self._path("store.json")) as f:
+                meta = json.load(f)
+            num_perm = meta["num_perm"]
+            minhash_bits = meta.get("minhash_bits",0)
+            scheme = meta.get("minhash_scheme","independent")
+            if sorted(meta.get("features",["strings"])) != sorted(kinds):
+                raise ValueError("feature store {0} holds {1} features, not {2}".format(
+                    directory,",".join(meta.get("features",["strings"])),",".join(kinds)))
+        else:
+            with open(self._path("store.json"),"w") as f:
+                json.dump({"num_perm":num_perm,"minhash_scheme":scheme,"minhash_bits":minhash_bits,
+                           "features":list(kinds)},f)
+        self.num_perm = num_perm
+        self.minhash_bits = minhash_bits
+        self.scheme = scheme
+        if minhash_bits:
+            self.signature_words = minhash_bits * ((num_perm + 63) // 64)
+        else:
+            self.signature_words = num_perm
+
+        # sha256 -> (path, offset, count), in the order the samples were added
+        self.samples = collections.OrderedDict()
+        if os.path.exists(self._path("samples.tsv")):
+            with open(self._path("samples.tsv")) as f:
+                for line in f:
+                    sha256,path,offset,count = line.rstrip("\n").split("\t")
+                    self.samples[sha256] = (path,int(offset),int(count))
+
+        # drop signatures left behind by an interrupted add()
+        signature_bytes = len(self.samples) * self.signature_words * 8
+        if os.path.exists(self._path("minhash.bin")) and \
+           os.path.getsize(self._path("minhash.bin")) > signature_bytes:
+            with open(self._path("minhash.bin"),"r+b") as f:
+                f.truncate(signature_bytes)
+
+        self.rows = dict((sha256,row) for row,sha256 in enumerate(self.samples))
+        self.stored_hashes = self._map("hashes.bin",None)
+        self.stored_signatures = self._map("minhash.bin",self.signature_words)
+        self.added = dict() # sha256 -> (hashes, signature) added since opening
+        self._dictionary = None
+
+    def _path(self,name):
+        return os.path.join(self.directory,name)
+
+    def _map(self,name,columns):
+        """
+        Memory-map one of the uint64 files, as rows of 'columns' if given.
+        """
+        path = self._path(name)
+        if os.path.exists(path) and os.path.getsize(path) > 0:
+            data = np.memmap(path,dtype="<u8",mode="r")
+        else:
+            data = np.zeros(0,dtype="<u8")
+        return data if columns is None else data.reshape(-1,columns)
+
+    def __contains__(self,sha256):
+        return sha256 in self.samples
+
+    @property
+    def dictionary(self):
+        """
+        The store's StringDictionary, loaded on first use.
+        """
+        if self._dictionary is None:
+            self._dictionary = StringDictionary(self.directory)
+        return self._dictionary
+
+    def path(self,sha256):
+        return self.samples[sha256][0]
+
+    def hashes(self,sha256):
+        """
+        Return the sorted string hashes of a stored sample.
+        """
+        if sha256 in self.added:
+            return self.added[sha256][0]
+        path,offset,count = self.samples[sha256]
+        return self.stored_hashes[offset:offset+count]
+
+    def signature(self,sha256):
+        """
+        Return the MinHash signature of a stored sample (packed, with
+        'minhash_bits').
+        """
+        if sha256 in self.added:
+            return self.added[sha256][1]
+        return self.stored_signatures[self.rows[sha256]]
+
+    def add(self,sha256,path,hashes):
+        """
+        Append a sample's string hashes and MinHash signature.
+        """
+        signature = self.minhash(hashes)
+        offset = os.path.getsize(self._path("hashes.bin")) // 8 if os.path.exists(self._path("hashes.bin")) else 0
+        with open(self._path("hashes.bin"),"ab") as f:
+            hashes.astype("<u8").tofile(f)
+        with open(self._path("minhash.bin"),"ab") as f:
+            signature.astype("<u8").tofile(f)
+        with open(self._path("samples.tsv"),"a") as f:
+            f.write("{0}\t{1}\t{2}\t{3}\n".format(sha256,path,offset,len(hashes)))
+        self.samples[sha256] = (path,offset,len(hashes))
+        self.rows[sha256] = len(self.rows)
+        self.added[sha256] = (hashes,signature)
+
+    def minhash(self,hashes):
+        """
+        Compute the MinHash signature of a set of string hashes in the
+        form kept by the store.
+        """
+        if self.scheme == "oph":
+            signature = oph_signature(hashes,self.num_perm)
+        else:
+            signature = minhash_signature(hashes,self.num_perm)
+        if self.minhash_bits:
+            return bbit_pack(signature.reshape(1,-1),self.minhash_bits)[0]
+        return signature
+
+    def edge_path(self):
+        """
+        Return the path of the stored similarity edges (a CSV edge file).
+        """
+        return self._path("edges.csv")
+
+def band_keys(signatures,bands):
+    """
+    Fold each of the 'bands' bands of every MinHash signature (one row
+    per sample) into a single uint64 key with mix64(), so that two
+    samples share a key exactly when they agree on the whole band
+    (barring 64-bit collisions). Return an (n, bands) array.
+    """
+    n,size = signatures.shape
+    width = size // bands
+    keys = np.zeros((n,bands),dtype=np.uint64)
+    for column in range(width):
+        keys = mix64(keys ^ signatures[:,column::width][:,:bands])
+    return keys
+
+class QueryIndex(object):
+    """
+    Nearest-neighbor index over a FeatureStore for 'which stored samples
+    are most similar to this file' queries. The MinHash signatures of
+    the store are cut into 'bands' bands, and for each band the sorted
+    (band key, row) pairs are saved next to the store as
+    lsh-<bands>.npy and memory-mapped, so loading the index costs
+    nothing and a lookup is one binary search per band. The file is
+    rebuilt when the store has grown since it was written.
+
+    The samples colliding with the query in at least one band are the
+    candidates; each is verified with the exact Jaccard index over the
+    stored string hashes and the best 'k' are returned. Queries only
+    read memory-mapped data and may run concurrently.
+
+    b-bit signatures are too coarse to band, so for a store with
+    'minhash_bits' the query is compared with every stored signature
+    by XOR and popcount instead (a few words per sample), and the
+    samples with the best estimates are the candidates.
+    """
+    def __init__(self,store,bands,kinds=("strings",)):
+        if store.num_perm % bands:
+            raise ValueError("{0} MinHash permutations cannot be cut into {1} bands".format(store.num_perm,bands))
+        self.store = store
+        self.bands = bands
+        self.kinds = kinds
+        self.digests = list(store.samples)
+        if store.minhash_bits:
+            return
+        path = os.path.join(store.directory,"lsh-{0}.npy".format(bands))
+        if os.path.exists(path):
+            self.table = np.load(path,mmap_mode="r")
+        if not os.path.exists(path) or self.table.shape[2] != len(self.digests):
+            keys = band_keys(np.asarray(store.stored_signatures),bands)
+            table = np.empty((bands,2,len(keys)),dtype=np.uint64)
+            for band in range(bands):
+                order = np.argsort(keys[:,band],kind="mergesort")
+                table[band,0] = keys[order,band]
+                table[band,1] = order
+            np.save(path,table)
+            self.table = np.load(path,mmap_mode="r")
+
+    def candidates(self,signature,k):
+        """
+        Return the rows of the stored samples that share a band with
+        'signature', or for b-bit signatures the rows of the 8k best
+        estimates.
+        """
+        if self.store.minhash_bits:
+            matches = bbit_matches(self.store.stored_signatures,signature,self.store.minhash_bits,self.store.num_perm)
+            count = min(8 * k,len(matches))
+            return set(np.argpartition(-matches,count - 1)[:count].tolist()) if count else set()
+        keys = band_keys(signature.reshape(1,-1),self.bands)[0]
+        rows = set()
+        for band in range(self.bands):
+            column = self.table[band,0]
+            start = np.searchsorted(column,keys[band],side="left")
+            end = np.searchsorted(column,keys[band],side="right")
+            rows.update(self.table[band,1,start:end].tolist())
+        return rows
+
+    def query(self,fullpath,k=10):
+        """
+        Return the 'k' stored samples most similar to the file
+        'fullpath' as (jaccard, sha256, path) tuples, best first.
+        """
+        hashes = hash_strings(getfeatures(fullpath,self.kinds))
+        signature = self.store.minhash(hashes)
+        results = []
+        for row in self.candidates(signature,k):
+            sha256 = self.digests[row]
+            stored = self.store.hashes(sha256)
+            intersection_length = len(np.intersect1d(hashes,stored,assume_unique=True))
+            union_length = len(hashes) + len(stored) - intersection_length
+            jaccard_index = float(intersection_length) / union_length if union_length else 0.0
+            results.append((jaccard_index,sha256,self.store.path(sha256)))
+        results.sort(key=lambda result: (-result[0],result[1]))
+        return results[:k]
+
+def answer_query(index,request,k):
+    """
+    Answer one query request: a JSON object {"path": ..., "k": ...} or
+    just a file path. Return the JSON response object.
+    """
+    start = time.time()
+    try:
+        if request.startswith("{"):
+            request = json.loads(request)
+            path,k = request["path"],int(request.get("k",k))
+        else:
+            path = request
+        results = index.query(path,k)
+    except (IOError,OSError,ValueError,KeyError) as error:
+        return {"error": str(error)}
+    return {
+        "path": path,
+        "milliseconds": (time.time() - start) * 1000.0,
+        "results": [{"jaccard": jaccard_index,"sha256": sha256,"path": stored_path}
+                    for jaccard_index,sha256,stored_path in results],
+    }
+
+class QueryServer(SocketServer.ThreadingMixIn,SocketServer.UnixStreamServer):
+    """
+    Serve QueryIndex queries on a local (Unix domain) socket, one thread
+    per connection. Each line received is a request for answer_query()
+    and gets one line of JSON back, so e.g.
+
+      echo /path/to/sample | socat - UNIX-CONNECT:query.sock
+
+    asks for the samples most similar to /path/to/sample.
+    """
+    daemon_threads = True
+
+    def __init__(self,path,index,k):
+        self.index = index
+        self.k = k
+        # only clear away a socket left behind by an earlier server
+        if os.path.exists(path):
+            if not stat.S_ISSOCK(os.stat(path).st_mode):
+                raise ValueError("{0} exists and is not a socket".format(path))
+            os.remove(path)
+        SocketServer.UnixStreamServer.__init__(self,path,QueryHandler)
+
+class QueryHandler(SocketServer.StreamRequestHandler):
+    def handle(self):
+        for line in iter(self.rfile.readline,b""):
+            request = line.decode("utf-8").strip()
+            if request:
+                response = answer_query(self.server.index,request,self.server.k)
+                self.wfile.write((json.dumps(response) + "\n").encode("utf-8"))
+                self.wfile.flush()
+
+def shard_tasks(num_samples,block_size):
+    """
+    Partition the samples of a store, in store order, into blocks of
+    'block_size' and return the block-pair tasks (a, b), b >= a, that
+    together cover every pair of samples exactly once.
+    """
+    blocks = (num_samples + block_size - 1) // block_size
+    return [(a,b) for a in range(blocks) for b in range(a,blocks)]
+
+def shard_task_path(shard_directory,task):
+    return os.path.join(shard_directory,"edges-{0:05d}-{1:05d}.csv".format(*task))
+
+def stop_hashes(store,max_df,block_size):
+    """
+    Return the sorted hashes of the stop strings of the whole store (see
+    build_inverted_index()), counting document frequencies block by
+    block so that only the vocabulary, not the samples, is in memory.
+    """
+    digests = list(store.samples)
+    cutoff = max_df * len(digests) if max_df <= 1.0 else max_df
+    vocabulary = np.zeros(0,dtype=np.uint64)
+    counts = np.zeros(0,dtype=np.int64)
+    if cutoff >= len(digests):
+        return vocabulary
+    for start in range(0,len(digests),block_size):
+        block = [np.asarray(store.hashes(sha256),dtype=np.uint64) for sha256 in digests[start:start+block_size]]
+        new = sum(len(hashes) for hashes in block)
+        vocabulary,inverse = np.unique(np.concatenate(block + [vocabulary]),return_inverse=True)
+        weights = np.concatenate([np.ones(new,dtype=np.int64),counts])
+        counts = np.bincount(inverse.ravel(),weights=weights,minlength=len(vocabulary)).astype(np.int64)
+    return vocabulary[counts > cutoff]
+
+shard_state = None
+
+def init_shard_worker(directory,num_perm,kinds,shard_directory,block_size,threshold):
+    """
+    Pool initializer of run_shards(): open the store in the worker.
+    """
+    global shard_state
+    store = FeatureStore(directory,num_perm,kinds)
+    stop = np.fromfile(os.path.join(shard_directory,"stop.bin"),dtype="<u8")
+    shard_state = (store,list(store.samples),stop,shard_directory,block_size,threshold)
+
+def run_shard_task(task):
+    """
+    Compute the edges between the samples of blocks a and b (the pairs
+    i < j within the block when a == b) from the stored string hashes,
+    with candidate_similarities() over an inverted index of the two
+    blocks, block a first, restricted to the rows of block a and the
+    columns of block b. The edges above the threshold go to
+    the task's own edge file, written under a temporary name and renamed
+    when complete, so a task either has its whole file or none.
+    """
+    store,digests,stop,shard_directory,block_size,threshold = shard_state
+    a,b = task
+    dictionary = StringDictionary()
+    def load(sha256):
+        hashes = np.asarray(store.hashes(sha256),dtype=np.uint64)
+        if len(stop):
+            hashes = hashes[~np.isin(hashes,stop)]
+        return dictionary.intern(hashes)
+
+    digests_b = digests[b * block_size:(b + 1) * block_size]
+    if a == b:
+        block_digests,rows = digests_b,None
+    else:
+        block_digests = digests[a * block_size:(a + 1) * block_size] + digests_b
+        rows = len(block_digests) - len(digests_b)
+    block_features = [load(sha256) for sha256 in block_digests]
+    postings,features,stop_strings = build_inverted_index(range(len(block_features)),dict(enumerate(block_features)),1.0)
+
+    path = shard_task_path(shard_directory,task)
+    writer = EdgeWriter(path + ".tmp","csv")
+    for i,j,jaccard_index in candidate_similarities(postings,features,rows,None,rows or 0):
+        if jaccard_index > threshold:
+            writer.edge(store.path(block_digests[i]),store.path(block_digests[j]),jaccard_index)
+    writer.close()
+    os.rename(path + ".tmp",path)
+    return task
+
+def run_shards(store,kinds,shard_directory,block_size,threshold,max_df,processes):
+    """
+    Compute all pairs of samples of a feature store as independent
+    block-pair tasks (see shard_tasks()) on 'processes' processes, each
+    writing its own edge file in 'shard_directory'. The partition is
+    fixed by the store order and the block size, and recorded with the
+    other parameters and the global stop strings the first time, so an
+    interrupted run can be restarted: tasks whose edge file exists are
+    skipped. Any task can also be run elsewhere on a copy of the store.
+    Return the list of tasks.
+    """
+    if not os.path.isdir(shard_directory):
+        os.makedirs(shard_directory)
+    meta = {"samples":len(store.samples),"block_size":block_size,"threshold":threshold,"max_df":max_df}
+    meta_path = os.path.join(shard_directory,"shards.json")
+    if os.path.exists(meta_path):
+        with open(meta_path) as f:
+            if json.load(f) != meta:
+                raise ValueError("shard directory {0} holds another partition or parameters".format(shard_directory))
+    else:
+        stop_hashes(store,max_df,block_size).astype("<u8").tofile(os.path.join(shard_directory,"stop.bin"))
+        with open(meta_path,"w") as f:
+            json.dump(meta,f)
+
+    tasks = shard_tasks(len(store.samples),block_size)
+    pending = [task for task in tasks if not os.path.exists(shard_task_path(shard_directory,task))]
+    print "{0} block-pair tasks, {1} already done ...".format(len(tasks),len(tasks) - len(pending))
+    arguments = (store.directory,store.num_perm,kinds,shard_directory,block_size,threshold)
+    if processes > 1 and len(pending) > 1:
+        pool = multiprocessing.Pool(processes,init_shard_worker,arguments)
+        try:
+            for done,task in enumerate(pool.imap_unordered(run_shard_task,pending),1):
+                print "Finished block pair {0} ({1}/{2}) ...".format(task,done,len(pending))
+        finally:
+            pool.terminate()
+    else:
+        init_shard_worker(*arguments)
+        for done,task in enumerate(pending,1):
+            run_shard_task(task)
+            print "Finished block pair {0} ({1}/{2}) ...".format(task,done,len(pending))
+    return tasks
+
+def merge_shards(shard_directory,tasks):
+    """
+    Generate the edges of all block-pair tasks, in task order.
+    """
+    for task in tasks:
+        for kind,edge in read_edges(shard_task_path(shard_directory,task),"csv"):
+            if kind == "edge":
+                yield edge
+
+def dot_quote(text):
+    """
+    Quote 'text' as a DOT identifier.
+    """
+    return '"' + text.replace('\\','\\\\').replace('"','\\"') + '"'
+
+def edge_penwidth(jaccard_index,threshold):
+    """
+    Pen width of a graph edge: thicker the further above the threshold.
+    """
+    return 1+(jaccard_index-threshold)*10
+
+class DotWriter(object):
+    """
+    Write an undirected DOT graph incrementally: every node and edge goes
+    to disk as soon as it is known and only the closing brace is left for
+    close(), so the graph is never held in memory.
+    """
+    def __init__(self,path):
+        self.f = open(path,"w")
+        self.f.write("graph {\n")
+
+    def node(self,path):
+        self.f.write("{0} [label={1}];\n".format(dot_quote(path),dot_quote(os.path.split(path)[-1][:10])))
+
+    def edge(self,malware1,malware2,penwidth):
+        self.f.write("{0} -- {1} [penwidth={2!r}];\n".format(dot_quote(malware1),dot_quote(malware2),penwidth))
+
+    def close(self):
+        self.f.write("}\n")
+        self.f.close()
+
+EDGE_FORMATS = ("csv","ndjson","bin")
+
+def edge_format(path,format=None):
+    """
+    Return 'format' if given, otherwise guess the edge file format from
+    the extension of 'path' (CSV unless it is .ndjson/.json or .bin).
+    """
+    if format is not None:
+        return format
+    extension = os.path.splitext(path)[1].lower()
+    if extension in (".ndjson",".json"):
+        return "ndjson"
+    if extension == ".bin":
+        return "bin"
+    return "csv"
+
+def csv_field(text):
+    """
+    Quote a CSV field if it contains a separator, quote or newline.
+    """
+    if any(c in text for c in ',"\r\n'):
+        return '"' + text.replace('"','""') + '"'
+    return text
+
+class EdgeWriter(object):
+    """
+    Stream similarity edges to disk as they are found, in one of three
+    formats:
+
+      csv     one 'malware1,malware2,jaccard' line per edge
+      ndjson  one {"node": path} object per sample and one
+              {"source": path, "target": path, "jaccard": value}
+              object per edge
+      bin     little-endian (uint32 source, uint32 target, float64
+              jaccard) records indexing the sample paths listed one
+              per line in the sidecar file PATH.nodes
+
+    Only ndjson and bin record the samples without edges. Appending is
+    supported for csv and ndjson.
+    """
+    def __init__(self,path,format=None,append=False):
+        self.format = edge_format(path,format)
+        if append and self.format == "bin":
+            raise ValueError("cannot append to a binary edge file")
+        if self.format == "bin":
+            self.f = open(path,"wb")
+            self.nodes = open(path + ".nodes","w")
+            self.ids = dict()
+        else:
+            self.f = open(path,"a" if append else "w")
+
+    def node(self,path):
+        if self.format == "bin":
+            self.ids[path] = len(self.ids)
+            self.nodes.write(path + "\n")
+        elif self.format == "ndjson":
+            self.f.write(json.dumps({"node":path}) + "\n")
+
+    def edge(self,malware1,malware2,jaccard_index):
+        if self.format == "bin":
+            self.f.write(struct.pack("<IId",self.ids[malware1],self.ids[malware2],jaccard_index))
+        elif self.format == "ndjson":
+            self.f.write(json.dumps({"source":malware1,"target":malware2,"jaccard":jaccard_index}) + "\n")
+        else:
+            self.f.write("{0},{1},{2!r}\n".format(csv_field(malware1),csv_field(malware2),jaccard_index))
+
+    def close(self):
+        self.f.close()
+        if self.format == "bin":
+            self.nodes.close()
+
+def read_edges(path,format=None):
+    """
+    Read back an edge file written by EdgeWriter, one record at a time.
+    Yield ("node", path) for every sample recorded in the file (ndjson
+    and bin only) and ("edge", (malware1, malware2, jaccard)) for every
+    edge, so arbitrarily large edge files are processed in constant
+    memory (apart from the node list of a binary edge file).
+    """
+    format = edge_format(path,format)
+    if not os.path.exists(path):
+        return
+    if format == "bin":
+        with open(path + ".nodes") as f:
+            nodes = [line.rstrip("\n") for line in f]
+        for node in nodes:
+            yield "node",node
+        record = struct.Struct("<IId")
+        with open(path,"rb") as f:
+            while True:
+                data = f.read(record.size * 4096)
+                if not data:
+                    break
+                for offset in range(0,len(data),record.size):
+                    source,target,jaccard_index = record.unpack_from(data,offset)
+                    yield "edge",(nodes[source],nodes[target],jaccard_index)
+    elif format == "ndjson":
+        with open(path) as f:
+            for line in f:
+                obj = json.loads(line)
+                if "node" in obj:
+                    yield "node",obj["node"]
+                else:
+                    yield "edge",(obj["source"],obj["target"],obj["jaccard"])
+    else:
+        with open(path) as f:
+            for malware1,malware2,jaccard_index in csv.reader(f):
+                yield "edge",(malware1,malware2,float(jaccard_index))
+
+def render_edges(edge_path,format,dot_path,threshold):
+    """
+    Build the DOT visualization from an edge file, streaming it through
+    a DotWriter. Samples are declared the first time they are seen.
+    """
+    dot = DotWriter(dot_path)
+    declared = set()
+    for kind,record in read_edges(edge_path,format):
+        nodes = [record] if kind == "node" else record[:2]
+        for node in nodes:
+            if node not in declared:
+                declared.add(node)
+                dot.node(node)
+        if kind == "edge":
+            malware1,malware2,jaccard_index = record
+            dot.edge(malware1,malware2,edge_penwidth(jaccard_index,threshold))
+    dot.close()
 
 if __name__ == '__main__':
     # Add command line parameters: target directory, output DOT file path, Jaccard distance threshold
@@ -51,12 +1829,13 @@ if __name__ == '__main__':
 
     parser.add_argument(
         "target_directory",
-        help="Directory containing malware"
+        help="Directory or zip/tar archive containing malware (an edge file with "
+        "--render, a sample with --query, a socket path with --serve)"
     )
 
     parser.add_argument(
-        "output_dot_file",
-        help="Where to save the output graph DOT file"
+        "output_dot_file",nargs="?",default=None,
+        help="Where to save the output graph DOT file (optional with --edges)"
     )
 
     parser.add_argument(
@@ -64,40 +1843,327 @@ if __name__ == '__main__':
         default=0.8,help="Threshold above which to create an 'edge' between samples"
     )
 
+    parser.add_argument(
+        "--max_document_frequency","-m",dest="max_df",type=float,
+        default=1.0,help="Drop strings found in more than this fraction of the samples "
+        "(or this many samples, if > 1) before comparing them"
+    )
+
+    parser.add_argument(
+        "--processes","-p",dest="processes",type=int,default=multiprocessing.cpu_count(),
+        help="Number of processes extracting features from the samples"
+    )
+
+    parser.add_argument(
+        "--features",dest="features",default="strings",
+        help="Comma-separated kinds of features to compare the samples on, "
+        "out of: " + ",".join(FEATURE_KINDS)
+    )
+
+    parser.add_argument(
+        "--weighting","-w",dest="weighting",choices=("none","idf"),default="none",
+        help="Weight the strings by their inverse document frequency and compare "
+        "the samples with the weighted Jaccard index"
+    )
+
+    parser.add_argument(
+        "--lsh_bands",dest="lsh_bands",type=int,default=0,
+        help="Generate candidate pairs by LSH over this many bands of ICWS sketches "
+        "instead of the inverted index (approximate, but each candidate is verified exactly)"
+    )
+
+    parser.add_argument(
+        "--sketch_size",dest="sketch_size",type=int,default=128,
+        help="Number of samples in an ICWS sketch (a multiple of --lsh_bands)"
+    )
+
+    parser.add_argument(
+        "--store","-s",dest="store",default=None,
+        help="Directory of the persistent feature store; samples already in it "
+        "(by SHA-256) are not extracted again"
+    )
+
+    parser.add_argument(
+        "--incremental","-i",dest="incremental",action="store_true",
+        help="Only compare samples new to the store against the stored ones and "
+        "append the new edges to the stored graph (requires --store)"
+    )
+
+    parser.add_argument(
+        "--minhash_permutations",dest="num_perm",type=int,
+        default=128,help="Number of MinHash permutations for a new feature store"
+    )
+
+    parser.add_argument(
+        "--minhash_scheme",dest="minhash_scheme",choices=MINHASH_SCHEMES,default="oph",
+        help="How a new feature store computes MinHash signatures: one hash function "
+        "per permutation, or one-permutation hashing with densification (faster)"
+    )
+
+    parser.add_argument(
+        "--minhash_bits",dest="minhash_bits",type=int,default=0,
+        help="Keep only this many low bits (typically 1-4) of each MinHash permutation "
+        "in a new feature store (b-bit minwise hashing; 0 keeps all 64)"
+    )
+
+    parser.add_argument(
+        "--edges","-e",dest="edges",default=None,
+        help="Stream the edges found to this edge file as they are found"
+    )
+
+    parser.add_argument(
+        "--edge_format",dest="edge_format",choices=EDGE_FORMATS,default=None,
+        help="Format of the edge file (by default guessed from its extension: "
+        ".ndjson, .bin, otherwise csv)"
+    )
+
+    parser.add_argument(
+        "--simhash_distance",dest="simhash_distance",type=int,default=None,
+        help="Collapse samples whose 64-bit SimHash is within this many bits of "
+        "a representative before the Jaccard join and expand the edges afterwards"
+    )
+
+    parser.add_argument(
+        "--simhash_links",dest="simhash_links",choices=("expand","representatives"),default="expand",
+        help="With --simhash_distance, verify every pair of samples of linked groups "
+        "(expand, exact), or only link each sample to its representative and to the "
+        "representatives its group has edges to (representatives, a reduced edge set "
+        "that is linear in the group sizes)"
+    )
+
+    parser.add_argument(
+        "--matrix",dest="matrix",default=None,
+        help="Compute the full Jaccard matrix of all pairs and save it to this .npy file"
+    )
+
+    parser.add_argument(
+        "--matrix_csv",dest="matrix_csv",default=None,
+        help="Also export the full Jaccard matrix as a CSV table (requires --matrix)"
+    )
+
+    parser.add_argument(
+        "--shards",dest="shards",default=None,
+        help="Compare all stored samples as block-pair tasks on --processes processes, "
+        "each writing its edge file to this directory (restartable), then merge them"
+    )
+
+    parser.add_argument(
+        "--shard_block_size",dest="shard_block_size",type=int,default=4096,
+        help="Number of samples per block with --shards"
+    )
+
+    parser.add_argument(
+        "--threads","-t",dest="threads",type=int,default=multiprocessing.cpu_count(),
+        help="Number of threads for the Jaccard matrix"
+    )
+
+    parser.add_argument(
+        "--families","-f",dest="families",default=None,
+        help="Cluster the samples into families (connected components of the "
+        "graph) and write 'path,family' lines to this CSV file"
+    )
+
+    parser.add_argument(
+        "--average_linkage",dest="average_linkage",action="store_true",
+        help="Refine each family by average-linkage clustering at the threshold"
+    )
+
+    parser.add_argument(
+        "--render",dest="render",action="store_true",
+        help="Only build the DOT graph from the edge file given as target_directory"
+    )
+
+    parser.add_argument(
+        "--query",dest="query",action="store_true",
+        help="Only print the stored samples most similar to the file given as target_directory"
+    )
+
+    parser.add_argument(
+        "--serve",dest="serve",action="store_true",
+        help="Answer similarity queries on the Unix socket given as target_directory"
+    )
+
+    parser.add_argument(
+        "--top","-k",dest="top",type=int,default=10,
+        help="Number of most similar samples returned per query"
+    )
+
+    parser.add_argument(
+        "--query_bands",dest="query_bands",type=int,default=32,
+        help="Number of LSH bands of the MinHash signatures used to find query candidates"
+    )
+
     args = parser.parse_args()
+    if args.incremental and args.store is None:
+        parser.error("--incremental requires --store")
+    if not 0 <= args.minhash_bits <= 16:
+        parser.error("--minhash_bits must be between 0 and 16")
+    if args.shards is not None and (args.store is None or args.incremental):
+        parser.error("--shards requires --store and cannot be used with --incremental")
+    if args.shards is not None and (args.matrix is not None or args.lsh_bands or
+                                    args.simhash_distance is not None or args.weighting != "none"):
+        parser.error("--shards compares exact unweighted Jaccard indices only")
+    if (args.query or args.serve) and args.store is None:
+        parser.error("--query and --serve require --store")
+    args.features = tuple(kind for kind in args.features.split(",") if kind)
+    if not args.features or any(kind not in FEATURE_KINDS for kind in args.features):
+        parser.error("--features must be a comma-separated subset of " + ",".join(FEATURE_KINDS))
+    if args.average_linkage and args.families is None:
+        parser.error("--average_linkage requires --families")
+    if args.lsh_bands and args.sketch_size % args.lsh_bands:
+        parser.error("--sketch_size must be a multiple of --lsh_bands")
+    if args.simhash_distance is not None and not 0 <= args.simhash_distance < SIMHASH_BITS:
+        parser.error("--simhash_distance must be between 0 and 63")
+    if args.simhash_distance is not None and args.matrix is not None:
+        parser.error("--simhash_distance cannot be used with --matrix")
+    if args.matrix_csv is not None and args.matrix is None:
+        parser.error("--matrix_csv requires --matrix")
+    if args.output_dot_file is None and (args.render or args.edges is None) and not (args.query or args.serve):
+        parser.error("nothing to write: give output_dot_file and/or --edges")
+
+    if args.render:
+        render_edges(args.target_directory,args.edge_format,args.output_dot_file,args.threshold)
+        raise SystemExit(0)
+
+    if args.query or args.serve:
+        index = QueryIndex(FeatureStore(args.store,args.num_perm,args.features,args.minhash_bits,args.minhash_scheme),args.query_bands,args.features)
+        if args.query:
+            response = answer_query(index,args.target_directory,args.top)
+            for result in response.get("results",[]):
+                print result["path"],result["sha256"],result["jaccard"]
+            if "error" in response:
+                raise SystemExit(response["error"])
+            print "Answered in {0:.1f} ms".format(response["milliseconds"])
+        else:
+            print "Serving queries on {0} ...".format(args.target_directory)
+            QueryServer(args.target_directory,index,args.top).serve_forever()
+        raise SystemExit(0)
+
     malware_paths = [] # where we'll store the malware file paths
-    malware_attributes = dict() # where we'll store the malware strings
-    graph = networkx.Graph() # the similarity graph
+    malware_attributes = dict() # where we'll store the malware string IDs
+    store = FeatureStore(args.store,args.num_perm,args.features,args.minhash_bits,args.minhash_scheme) if args.store else None
+
+    # walk the target directory tree or archive and get and store the strings
+    # of all of the malware PE files not yet in the store
+    known = frozenset(store.samples) if store is not None else frozenset()
+    dictionary = store.dictionary if store is not None else StringDictionary()
+    digests = dict()
+    new_paths = []
+    for path,sha256,hashes,strings,num_attributes in scan_samples(args.target_directory,args.features,known,
+                                                                  args.processes,keep_strings=store is not None):
+        malware_paths.append(path)
+        digests[path] = sha256
+        if hashes is None or (store is not None and sha256 in store):
+            continue
+        print "Extracted {0} attributes from {1} ...".format(num_attributes,path)
+        if store is not None:
+            store.add(sha256,path,hashes)
+        malware_attributes[path] = dictionary.intern(hashes,strings)
+        new_paths.append(path)
 
-    for root, dirs, paths in os.walk(args.target_directory):
-        # walk the target directory tree and store all of the file paths
-        for path in paths:
-            full_path = os.path.join(root,path)
-            malware_paths.append(full_path)
+    if args.shards is not None:
+        # compare every stored sample, block pair by block pair, each task
+        # writing its own edge file
+        malware_paths = [store.path(sha256) for sha256 in store.samples]
+        tasks = run_shards(store,args.features,args.shards,args.shard_block_size,
+                           args.threshold,args.max_df,args.processes)
+    elif args.incremental:
+        # compare the new samples against everything already in the store
+        new_digests = set(digests[path] for path in new_paths)
+        old_digests = [sha256 for sha256 in store.samples if sha256 not in new_digests]
+        for sha256 in old_digests:
+            malware_attributes[store.path(sha256)] = dictionary.intern(store.hashes(sha256))
+        malware_paths = new_paths + [store.path(sha256) for sha256 in old_digests]
+        rows = len(new_paths)
+        print "{0} new samples, {1} samples already in the store ...".format(len(new_paths),len(old_digests))
+    else:
+        for path in malware_paths:
+            if path not in malware_attributes:
+                malware_attributes[path] = dictionary.intern(store.hashes(digests[path]))
+        rows = None
 
-    # filter out any paths that aren't PE files
-    malware_paths = filter(pecheck, malware_paths)
+    # open the outputs: the graph and the edge files are written as edges are found
+    outputs = []
+    if args.output_dot_file is not None:
+        dot = DotWriter(args.output_dot_file)
+    else:
+        dot = None
+    if args.edges is not None:
+        outputs.append(EdgeWriter(args.edges,args.edge_format))
+    if args.families is not None:
+        families = FamilyWriter(args.families,args.threshold,args.average_linkage)
+        outputs.append(families)
 
-    # get and store the strings for all of the malware PE files
+    # add each malware file to the graph
     for path in malware_paths:
-        attributes = getstrings(path)
-        print "Extracted {0} attributes from {1} ...".format(len(attributes),path)
-        malware_attributes[path] = attributes
+        if dot is not None:
+            dot.node(path)
+        for output in outputs:
+            output.node(path)
+    if args.incremental:
+        # replay the edges found by earlier runs into every output, before
+        # the store's own edge file is opened for appending
+        for kind,(malware1,malware2,jaccard_index) in read_edges(store.edge_path()):
+            if jaccard_index <= args.threshold:
+                continue
+            if dot is not None:
+                dot.edge(malware1,malware2,edge_penwidth(jaccard_index,args.threshold))
+            for output in outputs:
+                output.edge(malware1,malware2,jaccard_index)
+    if store is not None:
+        outputs.append(EdgeWriter(store.edge_path(),"csv",append=args.incremental))
 
-        # add each malware file to the graph
-        graph.add_node(path,label=os.path.split(path)[-1][:10])
+    if args.shards is not None:
+        # merge the edge files of the block-pair tasks
+        edges = merge_shards(args.shards,tasks)
+    else:
+        # index the strings of all samples, dropping the stop strings
+        postings,features,stop_strings = build_inverted_index(malware_paths,malware_attributes,args.max_df)
+        print "Dropped {0} stop strings, indexed {1} strings ...".format(len(stop_strings),len(postings))
+        examples = [dictionary.string(id) for id in stop_strings[:5].tolist()]
+        if examples and None not in examples:
+            print "Stop strings include {0} ...".format(", ".join(repr(example) for example in examples))
 
+        weights = idf_weights(postings,len(malware_paths)) if args.weighting == "idf" else None
 
-    # iterate through all pairs of malware
-    for malware1,malware2 in itertools.combinations(malware_paths,2):
+        if args.simhash_distance is not None:
+            # only compare one representative of each group of near-duplicates
+            representatives,groups = collapse_near_duplicates(features,args.simhash_distance)
+            print "Collapsed {0} samples into {1} representatives ...".format(len(features),len(representatives))
+            search_postings,search_features = representative_index(features,representatives)
+            search_rows = rows if rows is None else bisect.bisect_left(representatives,rows)
+        else:
+            search_postings,search_features,search_rows = postings,features,rows
 
-        # compute the jaccard distance for the current pair
-        jaccard_index = jaccard(malware_attributes[malware1],malware_attributes[malware2])
+        if args.matrix is not None:
+            # compute the jaccard distance of every pair at once and take the edges from the matrix
+            matrix = jaccard_matrix(postings,features,threads=args.threads,weights=weights)
+            write_matrix(matrix,malware_paths,args.matrix,args.matrix_csv)
+            similarities = matrix_similarities(matrix,args.threshold,rows)
+        elif args.lsh_bands:
+            # compute the jaccard distance of the pairs of malware whose sketches collide
+            similarities = sketch_similarities(search_features,args.sketch_size,args.lsh_bands,search_rows,weights)
+        else:
+            # compute the jaccard distance of the pairs of malware that share at least one string
+            similarities = candidate_similarities(search_postings,search_features,search_rows,weights)
+        if args.simhash_distance is not None and args.simhash_links == "representatives":
+            similarities = link_representatives(similarities,groups,features,args.threshold,rows,weights)
+        elif args.simhash_distance is not None:
+            similarities = expand_similarities(similarities,groups,features,args.threshold,rows,weights)
+        edges = ((malware_paths[i],malware_paths[j],jaccard_index) for i,j,jaccard_index in similarities)
 
+    for malware1,malware2,jaccard_index in edges:
         # if the jaccard distance is above the threshold add an edge
         if jaccard_index > args.threshold:
             print malware1,malware2,jaccard_index
-            graph.add_edge(malware1,malware2,penwidth=1+(jaccard_index-args.threshold)*10)
+            if dot is not None:
+                dot.edge(malware1,malware2,edge_penwidth(jaccard_index,args.threshold))
+            for output in outputs:
+                output.edge(malware1,malware2,jaccard_index)
 
-    # write the graph to disk so we can visualize it
-    write_dot(graph,args.output_dot_file)
+    # close the graph, the edge files and the families so we can visualize them
+    if dot is not None:
+        dot.close()
+    for output in outputs:
+        output.close()
+    dictionary.close()
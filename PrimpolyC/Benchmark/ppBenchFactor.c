@@ -0,0 +1,296 @@
+/*==============================================================================
+|
+|  File Name:
+|
+|     ppBenchFactor.c
+|
+|  Description:
+|
+|     Benchmark for factoring polynomials modulo p:  square free factorization
+|     followed by either Berlekamp's method, or distinct degree factorization
+|     and Cantor-Zassenhaus, on random monic polynomials.  It sets the
+|     crossover used by factor_poly(), BERLEKAMP_MAXP and p below the degree.
+|
+|     Build from this directory against the arithmetic files, without
+|     Primpoly.c,
+|
+|         gcc -O2 -I.. -o ppBenchFactor ppBenchFactor.c ../pp*.c -lm -lpthread
+|
+|  Functions:
+|
+|     main
+|     factor_with
+|     same_factors
+|     elapsed_us
+|
+|  LEGAL
+|
+|     Primpoly Version 16.3 - A Program for Computing Primitive Polynomials.
+|     Copyright (C) 1999-2024 by Sean Erik O'Connor.  All Rights Reserved.
+|
+|     This program is free software: you can redistribute it and/or modify
+|     it under the terms of the GNU General Public License as published by
+|     the Free Software Foundation, either version 3 of the License, or
+|     (at your option) any later version.
+|
+|     This program is distributed in the hope that it will be useful,
+|     but WITHOUT ANY WARRANTY; without even the implied warranty of
+|     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+|     GNU General Public License for more details.
+|
+|     You should have received a copy of the GNU General Public License
+|     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+|
+|     The author's address is seanerikoconnor!AT!gmail!DOT!com
+|     with !DOT! replaced by . and the !AT! replaced by @
+|
+==============================================================================*/
+
+/*------------------------------------------------------------------------------
+|                                Include Files                                 |
+------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Primpoly.h"
+
+
+#define NUMPOLYS 64            /*  Polynomials factored per timing.          */
+
+#define BERLEKAMP     1        /*  Methods for factor_with().                */
+#define ZASSENHAUS    2
+
+
+/*==============================================================================
+|                                 elapsed_us                                   |
+================================================================================
+
+DESCRIPTION
+
+     Microseconds of processor time between two clock() readings.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static double elapsed_us( clock_t start, clock_t stop )
+{
+    return 1.0e6 * (double)(stop - start) / CLOCKS_PER_SEC ;
+
+} /* ===================== end of function elapsed_us ======================== */
+
+
+
+/*==============================================================================
+|                                 factor_with                                  |
+================================================================================
+
+DESCRIPTION
+
+     factor_poly() with the splitting method fixed, and the factors left in
+     the order found.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int factor_with( int method, residue * f, int n, int p, poly_factor * factors )
+{
+    poly_factor square_free[ MAXDEGPOLY ], same_degree[ MAXDEGPOLY ] ;
+    int         num_square_free, num_same_degree, count = 0, i, j ;
+
+    num_square_free = square_free_factor( f, n, p, square_free ) ;
+
+    for (i = 0 ;  i < num_square_free ;  ++i)
+    {
+        if (method == BERLEKAMP)
+        {
+            count += berlekamp_factor( &square_free[ i ], p, &factors[ count ] ) ;
+            continue ;
+        }
+
+        num_same_degree = distinct_degree_factor( &square_free[ i ], p, same_degree ) ;
+
+        for (j = 0 ;  j < num_same_degree ;  ++j)
+            count += equal_degree_factor( &same_degree[ j ], p, &factors[ count ] ) ;
+    }
+
+    return count ;
+
+} /* ===================== end of function factor_with ======================= */
+
+
+
+/*==============================================================================
+|                                same_factors                                  |
+================================================================================
+
+DESCRIPTION
+
+     YES if the two lists hold the same factors and multiplicities, in any
+     order.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int same_factors( poly_factor * a, int num_a, poly_factor * b, int num_b )
+{
+    int i, j, k ;
+
+    if (num_a != num_b)
+        return NO ;
+
+    for (i = 0 ;  i < num_a ;  ++i)
+    {
+        for (j = 0 ;  j < num_b ;  ++j)
+        {
+            if (a[ i ].degree != b[ j ].degree || a[ i ].multiplicity != b[ j ].multiplicity)
+                continue ;
+
+            for (k = 0 ;  k <= a[ i ].degree && a[ i ].poly[ k ] == b[ j ].poly[ k ] ;  ++k)
+                ;
+
+            if (k > a[ i ].degree)
+                break ;
+        }
+
+        if (j == num_b)
+            return NO ;
+    }
+
+    return YES ;
+
+} /* ===================== end of function same_factors ====================== */
+
+
+
+/*==============================================================================
+|                                    main                                      |
+================================================================================
+
+DESCRIPTION
+
+     For each prime p below, factor NUMPOLYS random monic polynomials of
+     degree n both ways, check the results agree and multiply back to f(x),
+     and time each.
+
+INPUT
+
+         $ ppBenchFactor [n]
+
+     n      Degree, default MAXDEGPOLY.
+
+OUTPUT
+
+     One line per prime:  the average number of irreducible factors, and
+     microseconds per factorization for each method.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int main( int argc, char * argv[] )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+static int primes[] = { 2, 3, 5, 7, 11, 13, 17, 31, 61, 127, 251,
+                        257, 1021, 4093, 16381, 32749 } ;
+
+static residue
+    f[ NUMPOLYS ][ MAXDEGPOLY + 1 ] ;       /*  Random monic f(x).          */
+
+static poly_factor
+    by_berlekamp[ NUMPOLYS ][ MAXDEGPOLY ], /*  Factors by each method.     */
+    by_zassenhaus[ NUMPOLYS ][ MAXDEGPOLY ] ;
+
+int
+    num_berlekamp[ NUMPOLYS ],
+    num_zassenhaus[ NUMPOLYS ],
+    n = MAXDEGPOLY,
+    p,
+    i, j, k,
+    num_primes = sizeof( primes ) / sizeof( primes[ 0 ] ),
+    total_factors,
+    agree ;
+
+double
+    us_berlekamp, us_zassenhaus ;
+
+clock_t
+    start ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (argc > 1)
+    n = atoi( argv[ 1 ] ) ;
+
+if (n < 2 || n > MAXDEGPOLY)
+{
+    printf( "ERROR:  n must be between 2 and %d.\n\n", MAXDEGPOLY ) ;
+    exit( 1 ) ;
+}
+
+srand( 314159 ) ;
+
+printf( "%d-bit residues, %d random polynomials of degree %d\n\n",
+        PP_RESIDUE_BITS, NUMPOLYS, n ) ;
+printf( "    p    factors   Berlekamp   DDF + C-Z\n" ) ;
+printf( "          (avg.)  (us/poly)   (us/poly)\n" ) ;
+
+for (k = 0 ;  k < num_primes ;  ++k)
+{
+    p = primes[ k ] ;
+
+    if (p > MAXRESIDUE)
+        break ;
+
+    init_gf_tables( p ) ;
+
+    for (i = 0 ;  i < NUMPOLYS ;  ++i)
+    {
+        for (j = 0 ;  j < n ;  ++j)
+            f[ i ][ j ] = (residue)(rand() % p) ;
+        f[ i ][ n ] = 1 ;
+    }
+
+    start = clock() ;
+    for (i = 0 ;  i < NUMPOLYS ;  ++i)
+        num_berlekamp[ i ] = factor_with( BERLEKAMP, f[ i ], n, p, by_berlekamp[ i ] ) ;
+    us_berlekamp = elapsed_us( start, clock() ) / NUMPOLYS ;
+
+    start = clock() ;
+    for (i = 0 ;  i < NUMPOLYS ;  ++i)
+        num_zassenhaus[ i ] = factor_with( ZASSENHAUS, f[ i ], n, p, by_zassenhaus[ i ] ) ;
+    us_zassenhaus = elapsed_us( start, clock() ) / NUMPOLYS ;
+
+    agree = YES ;
+    total_factors = 0 ;
+
+    for (i = 0 ;  i < NUMPOLYS ;  ++i)
+    {
+        if (!same_factors( by_berlekamp[ i ], num_berlekamp[ i ],
+                           by_zassenhaus[ i ], num_zassenhaus[ i ] ) ||
+            !is_factorization( f[ i ], n, p, by_berlekamp[ i ], num_berlekamp[ i ] ))
+            agree = NO ;
+
+        total_factors += num_berlekamp[ i ] ;
+    }
+
+    printf( "%5d %10.2f %11.1f %11.1f%s\n", p, (double) total_factors / NUMPOLYS,
+            us_berlekamp, us_zassenhaus, agree ? "" : "   MISMATCH" ) ;
+
+    if (!agree)
+        return 1 ;
+}
+
+return 0 ;
+
+} /* ========================== end of function main ======================== */
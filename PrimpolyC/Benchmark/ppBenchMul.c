@@ -0,0 +1,350 @@
+/*==============================================================================
+|
+|  File Name:
+|
+|     ppBenchMul.c
+|
+|  Description:
+|
+|     Benchmark for multiplication modulo p:  the division in mod(), Barrett
+|     reduction and the multiplication tables of init_gf_tables(), on the
+|     scaled row additions which reduce products mod f(x), and on whole
+|     exponentiations x ^ r (mod f(x), p).
+|
+|     Build from this directory against the arithmetic files, without
+|     Primpoly.c,
+|
+|         gcc -O2 -I.. -o ppBenchMul ppBenchMul.c ../pp*.c -lm -lpthread
+|
+|     adding -DPP_RESIDUE_BITS=8 -mssse3 to time the byte shuffles for p <= 16.
+|
+|  Functions:
+|
+|     main
+|     barrett_row
+|     division_row
+|     elapsed_ns
+|
+|  LEGAL
+|
+|     Primpoly Version 16.3 - A Program for Computing Primitive Polynomials.
+|     Copyright (C) 1999-2024 by Sean Erik O'Connor.  All Rights Reserved.
+|
+|     This program is free software: you can redistribute it and/or modify
+|     it under the terms of the GNU General Public License as published by
+|     the Free Software Foundation, either version 3 of the License, or
+|     (at your option) any later version.
+|
+|     This program is distributed in the hope that it will be useful,
+|     but WITHOUT ANY WARRANTY; without even the implied warranty of
+|     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+|     GNU General Public License for more details.
+|
+|     You should have received a copy of the GNU General Public License
+|     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+|
+|     The author's address is seanerikoconnor!AT!gmail!DOT!com
+|     with !DOT! replaced by . and the !AT! replaced by @
+|
+==============================================================================*/
+
+/*------------------------------------------------------------------------------
+|                                Include Files                                 |
+------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+#include "Primpoly.h"
+
+
+#define ROWLEN    MAXDEGPOLY   /*  Coefficients per scaled row addition.       */
+#define NUMROWS   4096         /*  Row additions per timing.                   */
+#define NUMPOWERS 64           /*  Exponentiations per timing.                 */
+
+
+/*==============================================================================
+|                                 elapsed_ns                                   |
+================================================================================
+
+DESCRIPTION
+
+     Nanoseconds of processor time between two clock() readings.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static double elapsed_ns( clock_t start, clock_t stop )
+{
+    return 1.0e9 * (double)(stop - start) / CLOCKS_PER_SEC ;
+
+} /* ===================== end of function elapsed_ns ======================== */
+
+
+
+/*==============================================================================
+|                                division_row                                 |
+================================================================================
+
+DESCRIPTION
+
+     t(x) = t(x) + c s(x) (mod p) the way the polynomial arithmetic did it
+     originally, with two divides per coefficient.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static void division_row( residue * t, residue * s, int c, int n, int p )
+{
+    int j ;
+
+    for (j = 0 ;  j <= n - 1 ;  ++j)
+
+        t[ j ] = mod( t[ j ] + mod( c * s[ j ], p ), p ) ;
+
+} /* ==================== end of function division_row ====================== */
+
+
+
+/*==============================================================================
+|                                 barrett_row                                  |
+================================================================================
+
+DESCRIPTION
+
+     t(x) = t(x) + c s(x) (mod p) using Barrett reduction.
+
+INPUT
+
+     m  (bigint)   The Barrett constant floor( 2^32 / p ).
+
+METHOD
+                                                           32
+     For 0 <= x < 2^32, q = (x m) >> 32 is at most one less than floor(x/p),
+     so x - q p is reduced with one conditional subtract.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static void barrett_row( residue * t, residue * s, int c, int n, int p, bigint m )
+{
+    int    j ;
+    bigint x, q ;
+
+    for (j = 0 ;  j <= n - 1 ;  ++j)
+    {
+        x = (bigint) t[ j ] + (bigint) c * s[ j ] ;
+        q = (x * m) >> 32 ;
+        x -= q * p ;
+
+        t[ j ] = (residue)(x >= (bigint) p ? x - p : x) ;
+    }
+
+} /* ===================== end of function barrett_row ====================== */
+
+
+
+/*==============================================================================
+|                                    main                                      |
+================================================================================
+
+DESCRIPTION
+
+     For each prime p below, time NUMROWS scaled row additions of length
+     ROWLEN using divides, Barrett reduction and the tables, then NUMPOWERS
+     exponentiations x ^ r (mod f(x), p) for random monic f(x) of degree n,
+     with and without the tables.  Every method's results are compared.
+
+INPUT
+
+         $ ppBenchMul [n]
+
+     n      Degree for the exponentiations, default 7.  Primes with p^n out
+            of range skip them.
+
+OUTPUT
+
+     One line per prime:  nanoseconds per coefficient for each row method
+     (table means byte shuffles when p <= 16 with 8-bit residues), and
+     microseconds per exponentiation, where table means bit planes for p = 3.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int main( int argc, char * argv[] )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+static int primes[] = { 2, 3, 5, 7, 11, 13, 17, 31, 61, 127, 251,
+                        257, 1021, 4093, 16381, 32749 } ;
+
+static residue
+    s[ NUMROWS ][ ROWLEN ],                 /*  Rows to add.                */
+    t_div[ ROWLEN ],                        /*  Sums by each method.        */
+    t_bar[ ROWLEN ],
+    t_tab[ ROWLEN ],
+    f[ MAXDEGPOLY + 1 ],                    /*  Random monic f(x).          */
+    g_div[ MAXDEGPOLY ],                    /*  x ^ r (mod f(x), p).        */
+    g_tab[ MAXDEGPOLY ],
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+int
+    c[ NUMROWS ],                           /*  Scale factors.              */
+    n = 7,
+    p,
+    i, j, k,
+    num_primes = sizeof( primes ) / sizeof( primes[ 0 ] ),
+    num_powers,                             /*  Exponentiations for this p. */
+    agree ;
+
+bigint
+    m,                                      /*  Barrett constant.           */
+    r = 0 ;                                 /*  (p^n - 1)/(p - 1)           */
+
+double
+    ns_div, ns_bar, ns_tab, us_div, us_tab ;
+
+clock_t
+    start ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (argc > 1)
+    n = atoi( argv[ 1 ] ) ;
+
+if (n < 2 || n > MAXDEGPOLY)
+{
+    printf( "ERROR:  n must be between 2 and %d.\n\n", MAXDEGPOLY ) ;
+    exit( 1 ) ;
+}
+
+srand( 314159 ) ;
+
+printf( "%d-bit residues, %d x %d coefficient rows, %d powers of degree %d\n\n",
+        PP_RESIDUE_BITS, NUMROWS, ROWLEN, NUMPOWERS, n ) ;
+printf( "    p     divide    Barrett      table   x^r divide    x^r table\n" ) ;
+printf( "         (ns/coeff) (ns/coeff) (ns/coeff)  (us/power)   (us/power)\n" ) ;
+
+for (k = 0 ;  k < num_primes ;  ++k)
+{
+    p = primes[ k ] ;
+
+    if (p > MAXRESIDUE)
+        break ;
+
+    m = ((bigint) 1 << 32) / p ;
+
+    for (i = 0 ;  i < NUMROWS ;  ++i)
+    {
+        c[ i ] = rand() % p ;
+
+        for (j = 0 ;  j < ROWLEN ;  ++j)
+            s[ i ][ j ] = (residue)(rand() % p) ;
+    }
+
+    for (j = 0 ;  j < ROWLEN ;  ++j)
+        t_div[ j ] = t_bar[ j ] = t_tab[ j ] = 0 ;
+
+
+    /*  Scaled row additions. */
+    gf_table_p = 0 ;
+
+    start = clock() ;
+    for (i = 0 ;  i < NUMROWS ;  ++i)
+        division_row( t_div, s[ i ], c[ i ], ROWLEN, p ) ;
+    ns_div = elapsed_ns( start, clock() ) / (NUMROWS * ROWLEN) ;
+
+    start = clock() ;
+    for (i = 0 ;  i < NUMROWS ;  ++i)
+        barrett_row( t_bar, s[ i ], c[ i ], ROWLEN, p, m ) ;
+    ns_bar = elapsed_ns( start, clock() ) / (NUMROWS * ROWLEN) ;
+
+    init_gf_tables( p ) ;
+
+    ns_tab = 0.0 ;
+    if (gf_table_p)
+    {
+        start = clock() ;
+        for (i = 0 ;  i < NUMROWS ;  ++i)
+            add_scaled_row( t_tab, s[ i ], c[ i ], ROWLEN, p ) ;
+        ns_tab = elapsed_ns( start, clock() ) / (NUMROWS * ROWLEN) ;
+    }
+    else
+        for (j = 0 ;  j < ROWLEN ;  ++j)
+            t_tab[ j ] = t_div[ j ] ;
+
+    agree = YES ;
+    for (j = 0 ;  j < ROWLEN ;  ++j)
+        if (t_bar[ j ] != t_div[ j ] || t_tab[ j ] != t_div[ j ])
+            agree = NO ;
+
+
+    /*  Exponentiations, the same f(x) with and without the tables, 
+        skipped when p^n is out of range. */
+    us_div = us_tab = 0.0 ;
+
+    num_powers = (n * log( (double) p ) < (NUMBITS - 2) * log( 2.0 )) ? NUMPOWERS : 0 ;
+
+    if (num_powers)
+        r = (power( p, n ) - 1) / (p - 1) ;
+
+    for (i = 0 ;  i < num_powers ;  ++i)
+    {
+        for (j = 0 ;  j < n ;  ++j)
+            f[ j ] = (residue)(rand() % p) ;
+        f[ n ] = 1 ;
+
+        /*  Without the packed table this times the generic routines for
+            p = 3 too. */
+        gf_table_p = 0 ;
+        start = clock() ;
+        construct_power_table( power_table, NULL, f, n, p ) ;
+        x_to_power( r, g_div, power_table, NULL, n, p ) ;
+        us_div += elapsed_ns( start, clock() ) / 1000.0 ;
+
+        init_gf_tables( p ) ;
+        start = clock() ;
+        construct_power_table( power_table, &gf3, f, n, p ) ;
+        x_to_power( r, g_tab, power_table, &gf3, n, p ) ;
+        us_tab += elapsed_ns( start, clock() ) / 1000.0 ;
+
+        for (j = 0 ;  j < n ;  ++j)
+            if (g_div[ j ] != g_tab[ j ])
+                agree = NO ;
+    }
+
+    printf( "%5d %10.2f %10.2f ", p, ns_div, ns_bar ) ;
+
+    if (gf_table_p)
+        printf( "%10.2f ", ns_tab ) ;
+    else
+        printf( "%10s ", "-" ) ;
+
+    if (num_powers)
+        printf( "%12.2f %12.2f", us_div / num_powers, us_tab / num_powers ) ;
+    else
+        printf( "%12s %12s", "-", "-" ) ;
+
+    printf( "%s\n", agree ? "" : "   MISMATCH" ) ;
+
+    if (!agree)
+        return 1 ;
+}
+
+return 0 ;
+
+} /* ========================== end of function main ======================== */
@@ -133,25 +133,43 @@ int
 bigint
     max_p_to_n = MAXPTON,          /* Maximum value of p ^ n.               */
 
-    max_num_poly,                  /* p ^ n, the number of polynomials to
+    max_num_poly,                  /* p ^ n, or fewer with constraints, the number of polynomials to
                                       test for primitivity.                 */
 
     num_poly = 0,                  /* Number of polynomials tested so far.  */
 
+    queued_num_poly[ PREFILTER_QUEUE_SIZE ],
+                                   /* num_poly when each candidate was queued. */
+
     r,                             /* The number (p ^ n - 1)/(p - 1).       */
 
     primes[ MAXNUMPRIMEFACTORS ],  /* The distinct prime factors of r.      */
     prim_poly_count = 0,           /* Counter for primitive polynomials found.        */
     num_prim_poly = 0 ;            /* Total number of possible primitive polynomials. */
 
+factoring_job
+    job ;                          /* The factorization of p ^ n - 1, from
+                                      which r's primes and the number of
+                                      primitive polynomials both follow.    */
+
+#ifdef PP_THREADS
+pthread_t
+    factoring_thread ;             /* Factors p ^ n - 1 while we pre-filter. */
+#endif
+
 int
     count[ MAXNUMPRIMEFACTORS ],   /* ... and their multiplicities.         */
     i,                             /* Prime index. */
+    k,                             /* Thread or batch index. */
     prime_count,                   /* Primes are stored in array locations 0
                                       through prime_count.                  */
 
-    f[ MAXDEGPOLY + 1 ],           /* Coefficients of the polynomial f(x)  
-                                      which we test for primitivity.        */
+    num_queued = 0,                /* Number of candidates in the queue,    */
+    next_queued = 0,               /* ... and the next one to test.         */
+    queued_counts[ PREFILTER_QUEUE_SIZE ][ 3 ],
+                                   /* The three pre-filter counts then.     */
+    queued_index = -1,             /* Queue entry f(x) came from, or -1.    */
+    is_candidate,                  /* f(x) passed the first three tests.    */
 
     a = 0,                         /* Integer in the order r test.          */
 
@@ -177,11 +195,68 @@ int
     listAllPrimitivePolynomials  = NO, /* Print ALL primitive polynomials?              */
     printStatistics              = NO, /* Print statistics?                             */
     printHelp                    = NO, /* Print help information?                       */
-    selfCheck                    = NO, /* Do a self-check?  Time consuming!             */
+    selfCheck                    = NO , /* Do a self-check?  Time consuming!            */
+    conwayPolynomial             = NO , /* Find the Conway polynomial instead?          */
+    orderOfPolynomial            = NO , /* Find the order of x modulo testPolynomial?   */
+    factorPolynomial             = NO , /* Factor testPolynomial into irreducibles?     */
+    irreduciblePolynomial        = NO , /* Irreducible instead of primitive?            */
+    num_threads                  = 1 ,  /* Threads testing for irreducibility.          */
+    num_batch,                          /* Candidates in the current batch.             */
+    is_irreducible_poly          = NO , /* YES once an irreducible one is found.        */
+    pre_period,                         /* Power of x dividing testPolynomial.          */
+    num_factors ;                       /* Number of its factors found.                 */
+
+residue
+    f[ MAXDEGPOLY + 1 ],           /* Coefficients of the polynomial f(x)  
+                                      which we test for primitivity.        */
+
+    next_f[ MAXDEGPOLY + 1 ],      /* Where the search resumes after the
+                                      queued candidates are tested.         */
+
+    queue[ PREFILTER_QUEUE_SIZE ][ MAXDEGPOLY + 1 ],
+                                   /* Candidates which passed the first
+                                      three tests while r was factored.     */
 
     /*  x ^ n , ... , x ^ 2n-2 (mod f(x), p) */
     power_table[ MAXDEGPOLY - 1 ] [ MAXDEGPOLY ] ;
 
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+
+poly_constraints
+    constraints ;                  /* Restrictions on the coefficients of f(x). */
+
+static conway_cache
+    conway ;                       /* Conway polynomials of the divisors of n. */
+
+static poly_factor
+    factors[ MAXDEGPOLY ] ;        /* Factors of the polynomial in factor and
+                                      order modes.                          */
+
+bigint
+    order ;                        /* Order of x modulo that polynomial.       */
+
+static residue
+    batch[ IRRED_BATCH_SIZE ][ MAXDEGPOLY + 1 ] ;
+                                   /* Candidates tested for irreducibility
+                                      together.                            */
+static int
+    batch_is_irreducible[ IRRED_BATCH_SIZE ] ;
+
+irreducible_job
+    irred_job[ MAXTHREADS ] ;      /* Each thread's slice of the batch.    */
+
+bigint
+    num_irred_poly = 0,            /* Number of irreducibles of degree n.  */
+    irred_poly_count = 0 ;         /* Irreducibles found so far.           */
+
+#ifdef PP_THREADS
+pthread_t
+    irred_thread[ MAXTHREADS ] ;
+int
+    irred_thread_started[ MAXTHREADS ] ;
+#endif
 
 char outputFormat[ _MAX_PATH ] ; /* Formatting for printf's (used only when printing bigints) */
 
@@ -220,6 +295,22 @@ char * help =
      "       prints search statistics.\n"
      "   pp -a 2 4\n"
      "       lists ALL primitive polynomials of degree 4 modulo 2.\n"
+     "   pp -a 2 8 a0=1 a7=nz w=5\n"
+     "       lists only those with the constant term 1, the x^7 term nonzero and\n"
+     "       at most 5 terms.  Constraints are ak=v or ak=nz for the coefficient of\n"
+     "       x^k, t=v or t=nz for the trace (minus the x^(n-1) coefficient), and\n"
+     "       w=m for at most m nonzero terms.\n"
+     "   pp -C 2 4\n"
+     "       finds the Conway polynomial of degree 4 modulo 2;  with -s, also\n"
+     "       those of the divisors of 4 it needed.\n"
+     "   pp -o 2 5 x^5+x^3+x^2+1\n"
+     "       finds the order of x modulo any polynomial of degree 5 modulo 2, the\n"
+     "       period of its shift register sequences;  with -s, also its factors.\n"
+     "   pp -f 3 4 x^4+2x^3+x+2\n"
+     "       factors a polynomial of degree 4 modulo 3 into irreducibles.\n"
+     "   pp -i 2 4\n"
+     "       finds an irreducible polynomial, not necessarily primitive;  with -a,\n"
+     "       lists them all and checks their number against the necklace formula.\n"
      "\n\n"
 } ;
 
@@ -245,9 +336,14 @@ parse_command_line( argc,
                     &printStatistics,
                     &printHelp,
                     &selfCheck,
+                    &conwayPolynomial,
+                    &orderOfPolynomial,
+                    &factorPolynomial,
+                    &irreduciblePolynomial,
                     &p,
                     &n,
-                    testPolynomial ) ;
+                    testPolynomial,
+                    &constraints ) ;
 
 if (printHelp)
 {
@@ -269,6 +365,15 @@ if (n > MAXDEGPOLY || n < 2)
 }
 
 
+if (p > MAXRESIDUE)
+{
+    printf( "ERROR:  p must be at most %d with %d-bit coefficients.\n"
+            "        Rebuild with -DPP_RESIDUE_BITS=%d for larger p.\n\n",
+            MAXRESIDUE, PP_RESIDUE_BITS, PP_RESIDUE_BITS == 8 ? 16 : 32 ) ;
+    exit( 1 ) ;
+}
+
+
 /*  Check to see if p is a prime. */
 if (!is_almost_surely_prime( p ))
 {
@@ -278,6 +383,71 @@ if (!is_almost_surely_prime( p ))
 
 
 
+/*  Multiplication tables mod p for small p, before any arithmetic on f(x). */
+init_gf_tables( p ) ;
+
+
+/*
+     Factor and order modes work on the given polynomial instead of searching.
+*/
+if (factorPolynomial || orderOfPolynomial)
+{
+    if (testPolynomial[ n ] == 0)
+    {
+        printf( "ERROR:  Expecting a polynomial of degree %d, e.g. x^%d+1\n\n", n, n ) ;
+        exit( 1 ) ;
+    }
+
+    /*  Make it monic;  that leaves the order unchanged. */
+    a = inverse_mod_p( testPolynomial[ n ], p ) ;
+
+    for (i = 0 ;  i <= n ;  ++i)
+        f[ i ] = (residue)(((bigint) testPolynomial[ i ] * a) % p) ;
+}
+
+/*
+     Factoring only ever raises to the pth power, so unlike the other modes it
+     works for any p ^ n.
+*/
+if (factorPolynomial)
+{
+    num_factors = factor_poly( f, n, p, factors ) ;
+
+    printf( "\n\nFactors of the polynomial of degree %d modulo %d\n\n", n, p ) ;
+    write_poly( f, n ) ;
+
+    if (testPolynomial[ n ] != 1)
+        printf( "\n\ndivided by its leading coefficient %d", testPolynomial[ n ] ) ;
+
+    printf( "\n\n" ) ;
+
+    for (i = 0 ;  i < num_factors ;  ++i)
+    {
+        printf( "    Multiplicity %2d :  ", factors[ i ].multiplicity ) ;
+        write_poly( factors[ i ].poly, factors[ i ].degree ) ;
+        printf( "\n" ) ;
+    }
+
+    if (selfCheck)
+    {
+        printf( "\nConfirming the factors with an independent check.\n\n" ) ;
+
+        if (is_factorization( f, n, p, factors, num_factors ))
+            printf( "    -Factorization is confirmed.\n\n" ) ;
+        else
+        {
+            printf( "Internal error:  \n"
+                    "Factorization confirmation test failed.\n"
+                    "Please let the author know by e-mail.\n\n" ) ;
+            return 1 ;
+        }
+    }
+
+    if (!orderOfPolynomial)
+        return 0 ;
+}
+
+
 /*
                n
     Return if p  > MAXPTON because then we'll exceed the computer integer precision.
@@ -291,29 +461,368 @@ if (n * log( (double) p ) > log( (double) (sbigint) max_p_to_n ))
 
 
 /*
-                         n
-              n         p  - 1
-     Compute p  and r = ------.
-                        p - 1
+                  n
+                 p  - 1
+     Compute r = ------ and the number of polynomials to test, which is
+                 p - 1
+      n
+     p  less those the constraints rule out.
 */
-max_num_poly = power( p, n ) ;
+r = (power( p, n ) - 1) / (p - 1) ;
 
-r = (max_num_poly - 1) / (p - 1) ;
+max_num_poly = num_trial_polys( n, p, &constraints ) ;
 
 
 
 
-/*  Factor r into distinct primes. */
-if (printStatistics)
+/*                                                          n
+     Factor r into distinct primes by way of the factorization of p  - 1.
+     We factor on a separate thread where we can:  the first three tests
+     don't need the primes of r, so in the meantime we pre-filter candidate
+     polynomials and queue the survivors for the order tests.
+*/
+job.p    = p ;
+job.n    = n ;
+job.done = NO ;
+
+/*                       n
+     Initialize f(x) to x  + (-1).  Then, when f(x) passes through function 
+                                                                          n
+     next_trial_poly for the first time, it will have the correct value, x
+     The order mode keeps the given polynomial instead.
+*/
+if (!orderOfPolynomial)
+    initial_trial_poly( f, n, &constraints ) ;
+
+
+/*
+     Conway mode factors p ^ m - 1 for each degree m it searches on its own.
+*/
+if (conwayPolynomial)
 {
-    sprintf( outputFormat, "%s%s%s", "\nFactoring r = ", bigintOutputFormat, " into\n    " ) ;
-    printf( outputFormat, r ) ;
+    memset( &conway, 0, sizeof( conway ) ) ;
+
+    if (!conway_polynomial( p, n, f, &conway ))
+    {
+        printf( "Internal error:  \n"
+                "Failed to find the Conway polynomial.\n"
+                "Please let the author know by e-mail.\n" ) ;
+        exit( 1 ) ;
+    }
+
+    printf( "\n\nConway polynomial modulo %d of degree %d\n\n", p, n ) ;
+    write_poly( f, n ) ;
+    printf( "\n\n" ) ;
+
+    if (printStatistics)
+    {
+        printf( "+--------- Conway polynomials found -------------------------------------------------\n" ) ;
+        printf( "|\n" ) ;
+
+        for (i = 1 ;  i <= n ;  ++i)
+
+            if (conway.found[ i ])
+            {
+                printf( "| Degree %3d, %s, ", i,
+                        conway.method[ i ] == CONWAY_BY_ROOTS ? "by roots " : "by search" ) ;
+                sprintf( outputFormat, "%s%s", bigintOutputFormat, " candidates : " ) ;
+                printf( outputFormat, conway.tested[ i ] ) ;
+                write_poly( conway.poly[ i ], i ) ;
+                printf( "\n" ) ;
+            }
+
+        printf( "|\n" ) ;
+        printf( "+--------------------------------------------------------------------------------------\n" ) ;
+    }
+
+    if (selfCheck)
+    {
+        printf( "\nConfirming polynomial is primitive with an independent check.\n"
+                "Warning:  You may wait an impossibly long time!\n\n" ) ;
+
+        if (maximal_order( f, n, p ))
+            printf( "    -Polynomial is confirmed to be primitive.\n\n" ) ;
+        else
+        {
+            printf( "Internal error:  \n"
+                    "Primitive polynomial confirmation test failed.\n"
+                    "Please let the author know by e-mail.\n\n" ) ;
+            return 1 ;
+        }
+    }
+
+    return 0 ;
 }
 
-prime_count = factor( r, primes, count ) ;
+if (orderOfPolynomial)
+{
+    order = order_of_x( f, n, p, &pre_period, factors, &num_factors ) ;
+
+    printf( "\n\nOrder of x modulo the polynomial of degree %d modulo %d\n\n", n, p ) ;
+    write_poly( f, n ) ;
+
+    sprintf( outputFormat, "\n\nis %s", bigintOutputFormat ) ;
+    printf( outputFormat, order ) ;
+
+    if (pre_period > 0)
+        printf( ", once past the first %d powers of x", pre_period ) ;
+
+    printf( ".\n\n" ) ;
+
+    if (printStatistics)
+    {
+        printf( "+--------- Factors ------------------------------------------------------------------\n" ) ;
+        printf( "|\n" ) ;
+
+        if (pre_period > 0)
+            printf( "| x ^ %d\n", pre_period ) ;
+
+        for (i = 0 ;  i < num_factors ;  ++i)
+        {
+            printf( "| Multiplicity %2d, %2d irreducibles of degree %2d, order ",
+                    factors[ i ].multiplicity,
+                    factors[ i ].degree / factors[ i ].factor_degree,
+                    factors[ i ].factor_degree ) ;
+            sprintf( outputFormat, "%s%s", bigintOutputFormat, " : " ) ;
+            printf( outputFormat, factors[ i ].order ) ;
+            write_poly( factors[ i ].poly, factors[ i ].degree ) ;
+            printf( "\n" ) ;
+        }
+
+        printf( "|\n" ) ;
+        printf( "+--------------------------------------------------------------------------------------\n" ) ;
+    }
+
+    if (selfCheck)
+    {
+        printf( "\nConfirming the order with an independent check.\n\n" ) ;
+
+        if (order_is_exact( f, n, p, order, pre_period ))
+            printf( "    -Order is confirmed.\n\n" ) ;
+        else
+        {
+            printf( "Internal error:  \n"
+                    "Order confirmation test failed.\n"
+                    "Please let the author know by e-mail.\n\n" ) ;
+            return 1 ;
+        }
+    }
+
+    return 0 ;
+}
+
+/*
+     Irreducible mode needs no order tests, so doesn't factor r at all.
+     Candidates go in batches, each split among the threads, and are
+     reported in order.
+*/
+if (irreduciblePolynomial)
+{
+    num_irred_poly = num_irreducible( p, n ) ;
+
+    if (printStatistics || listAllPrimitivePolynomials)
+    {
+        sprintf( outputFormat, "%s%s%s", "\nTotal number of irreducible polynomials = ", bigintOutputFormat, ".  Begin testing...\n\n" ) ;
+        printf( outputFormat, num_irred_poly ) ;
+    }
+
+#ifdef PP_THREADS
+    num_threads = (int) sysconf( _SC_NPROCESSORS_ONLN ) ;
+
+    if (num_threads > MAXTHREADS)
+        num_threads = MAXTHREADS ;
+    else if (num_threads < 1)
+        num_threads = 1 ;
+#endif
+
+    while (num_poly < max_num_poly && (listAllPrimitivePolynomials || !is_irreducible_poly))
+    {
+        /*  Look at only a few at a time when one will do. */
+        for (num_batch = 0 ;  num_poly < max_num_poly &&
+             num_batch < (listAllPrimitivePolynomials ? IRRED_BATCH_SIZE : num_threads) ;
+             ++num_batch)
+        {
+            next_trial_poly( f, n, p, &constraints ) ;
+            ++num_poly ;
+
+            for (i = 0 ;  i <= n ;  ++i)
+                batch[ num_batch ][ i ] = f[ i ] ;
+        }
+
+        for (k = 0 ;  k < num_threads ;  ++k)
+        {
+            irred_job[ k ].polys          = batch ;
+            irred_job[ k ].is_irreducible = batch_is_irreducible ;
+            irred_job[ k ].first          = k * num_batch / num_threads ;
+            irred_job[ k ].last           = (k + 1) * num_batch / num_threads ;
+            irred_job[ k ].n              = n ;
+            irred_job[ k ].p              = p ;
+        }
+
+#ifdef PP_THREADS
+        for (k = 1 ;  k < num_threads ;  ++k)
+            irred_thread_started[ k ] = 
+                (pthread_create( &irred_thread[ k ], NULL, run_irreducible_job, &irred_job[ k ] ) == 0) ;
+#endif
+
+        run_irreducible_job( &irred_job[ 0 ] ) ;
+
+#ifdef PP_THREADS
+        for (k = 1 ;  k < num_threads ;  ++k)
+            if (irred_thread_started[ k ])
+                pthread_join( irred_thread[ k ], NULL ) ;
+            else
+                run_irreducible_job( &irred_job[ k ] ) ;
+#endif
+
+        for (k = 0 ;  k < num_batch ;  ++k)
+        {
+            if (!batch_is_irreducible[ k ])
+                continue ;
+
+            ++irred_poly_count ;
+            is_irreducible_poly = YES ;
+
+            /*  f(x) is where the search resumes, so only take the first. */
+            if (!listAllPrimitivePolynomials)
+            {
+                for (i = 0 ;  i <= n ;  ++i)
+                    f[ i ] = batch[ k ][ i ] ;
+
+                /*  Don't count the rest of the batch as tested. */
+                num_poly -= num_batch - k - 1 ;
+                break ;
+            }
+
+            printf( "\n\nIrreducible polynomial " ) ;
+
+            if (constraints.active)
+                sprintf( outputFormat, "%s ", bigintOutputFormat ) ;
+            else
+                sprintf( outputFormat, "%s of %s ", bigintOutputFormat, bigintOutputFormat ) ;
+
+            printf(  outputFormat, irred_poly_count, num_irred_poly ) ;
+            printf( "modulo %d of degree %d\n\n", p, n ) ;
+            write_poly( batch[ k ], n ) ;
+            printf( "\n\n" ) ;
+        }
+    }
+
+    printf( "\n\n" ) ;
+
+    if (listAllPrimitivePolynomials && is_irreducible_poly)
+        ; /* We're done */
+    else if (is_irreducible_poly)
+    {
+        printf( "\n\nIrreducible polynomial modulo %d of degree %d\n\n", p, n ) ;
+        write_poly( f, n ) ;
+        printf( "\n\n" ) ;
+    }
+    else
+    {
+        printf( "No irreducible polynomial modulo %d of degree %d satisfies the constraints.\n\n",
+                p, n ) ;
+        exit( 1 ) ;
+    }
+
+    if (printStatistics)
+    {
+        printf( "+--------- Statistics -----------------------------------------------------------------\n" ) ;
+        printf( "|\n" ) ;
+        sprintf( outputFormat, "%s%s%s", "| Total num. degree %3d polynomials mod %3d :    ", bigintOutputFormat, "\n" ) ;
+        printf( outputFormat, n, p, max_num_poly ) ;
+        sprintf( outputFormat, "%s%s%s", "| Actually tested :                              ", bigintOutputFormat, "\n" ) ;
+        printf( outputFormat,  num_poly ) ;
+        sprintf( outputFormat, "%s%s%s", "| Irreducible :                                  ", bigintOutputFormat, "\n" ) ;
+        printf( outputFormat,  irred_poly_count ) ;
+        printf( "| Threads :                                      %d\n",  num_threads ) ;
+        printf( "|\n" ) ;
+        printf( "+--------------------------------------------------------------------------------------\n" ) ;
+    }
+
+    /*  Listing them all should find exactly as many as the formula says. */
+    if (listAllPrimitivePolynomials && !constraints.active && irred_poly_count != num_irred_poly)
+    {
+        printf( "Internal error:  \n" ) ;
+        sprintf( outputFormat, "Found %s irreducible polynomials but expected %s.\n",
+                 bigintOutputFormat, bigintOutputFormat ) ;
+        printf( outputFormat, irred_poly_count, num_irred_poly ) ;
+        printf( "Please let the author know by e-mail.\n\n" ) ;
+        return 1 ;
+    }
+
+    if (selfCheck && !listAllPrimitivePolynomials)
+    {
+        printf( "\nConfirming polynomial is irreducible with an independent check.\n\n" ) ;
+
+        num_factors = factor_poly( f, n, p, factors ) ;
+
+        if (num_factors == 1 && factors[ 0 ].multiplicity == 1)
+            printf( "    -Polynomial is confirmed to be irreducible.\n\n" ) ;
+        else
+        {
+            printf( "Internal error:  \n"
+                    "Irreducible polynomial confirmation test failed.\n"
+                    "Please let the author know by e-mail.\n\n" ) ;
+            return 1 ;
+        }
+    }
+
+    return 0 ;
+}
+
+#ifdef PP_THREADS
+pthread_mutex_init( &job.lock, NULL ) ;
+
+/*  On a single processor the two would only take turns. */
+if (sysconf( _SC_NPROCESSORS_ONLN ) > 1 &&
+    pthread_create( &factoring_thread, NULL, run_factoring_job, &job ) == 0)
+{
+    while (!factoring_done( &job ) && num_queued < PREFILTER_QUEUE_SIZE && 
+           num_poly <= max_num_poly)
+    {
+        next_trial_poly( f, n, p, &constraints ) ;
+        ++num_poly ;
+
+        construct_power_table( power_table, &gf3, f, n, p ) ;
+
+        if (passes_prefilter( f, power_table, &gf3, n, p,
+                              &num_const_coeff_prim_root,
+                              &num_free_of_linear_factors,
+                              &num_irred_to_power ))
+        {
+            for (i = 0 ;  i <= n ;  ++i)
+                queue[ num_queued ][ i ] = f[ i ] ;
+
+            queued_num_poly[ num_queued ]     = num_poly ;
+            queued_counts[ num_queued ][ 0 ] = num_const_coeff_prim_root ;
+            queued_counts[ num_queued ][ 1 ] = num_free_of_linear_factors ;
+            queued_counts[ num_queued ][ 2 ] = num_irred_to_power ;
+
+            ++num_queued ;
+        }
+    }
+
+    pthread_join( factoring_thread, NULL ) ;
+}
+#endif
+
+/*  No threads, or we couldn't start one. */
+if (!job.done)
+    run_factoring_job( &job ) ;
+
+#ifdef PP_THREADS
+/*  Only now:  run_factoring_job() locks it too. */
+pthread_mutex_destroy( &job.lock ) ;
+#endif
+
+prime_count = factor_r( &job.pn1, p, primes, count ) ;
 
 if (printStatistics)
 {
+    sprintf( outputFormat, "%s%s%s", "\nFactoring r = ", bigintOutputFormat, " into\n    " ) ;
+    printf( outputFormat, r ) ;
+
     for (i = 0 ;  i <= prime_count ;  ++i)
     {
         if (count[ i ] == 1)
@@ -330,18 +839,10 @@ if (printStatistics)
     printf( "\n\n" ) ;
 }
 
-
-/*                       n
-     Initialize f(x) to x  + (-1).  Then, when f(x) passes through function 
-                                                                          n
-     next_trial_poly for the first time, it will have the correct value, x
-*/
-initial_trial_poly( f, n ) ;
-
 if (printStatistics || listAllPrimitivePolynomials)
 {
     sprintf( outputFormat, "%s%s%s", "Total number of primitive polynomials = ", bigintOutputFormat, ".  Begin testing...\n\n" ) ;
-    num_prim_poly = EulerPhi( power( p, n ) - 1 ) / n ;
+    num_prim_poly = EulerPhi_factored( &job.pn1 ) / n ;
     printf( outputFormat, num_prim_poly ) ;
 }
 
@@ -350,102 +851,127 @@ if (printStatistics || listAllPrimitivePolynomials)
 /*
      Generate and test all possible n th degree, monic, modulo p polynomials
      f(x).  A polynomial is primitive if passes all the tests successfully.
+     Test the queued candidates first, then pick up the search where the
+     pre-filtering left off.
 */
-do {
-    next_trial_poly( f, n, p ) ;      /* Try another polynomal. */
-    ++num_poly ;
+for (i = 0 ;  i <= n ;  ++i)
+    next_f[ i ] = f[ i ] ;
 
-    #ifdef DEBUG_PP_PRIMPOLY
-    printf( "\nNext trial polynomial:  " ) ;
-    write_poly( f, n ) ;
-    printf( "\n" ) ;
-    #endif
+stopTesting = (num_queued == 0 && num_poly > max_num_poly) ;
 
-    /*                         n         2n-2
-        Precompute the powers x ,  ..., x     (mod f(x), p)
-        for use in all later computations.
-    */
-    construct_power_table( power_table, f, n, p ) ;
+while (!stopTesting)
+{
+    if (next_queued < num_queued)
+    {
+        for (i = 0 ;  i <= n ;  ++i)
+            f[ i ] = queue[ next_queued ][ i ] ;
+
+        queued_index = next_queued++ ;
+
+        construct_power_table( power_table, &gf3, f, n, p ) ;
+
+        is_candidate = YES ;
+    }
+    else
+    {
+        if (num_queued > 0)  /* Back to where the search left off. */
+        {
+            for (i = 0 ;  i <= n ;  ++i)
+                f[ i ] = next_f[ i ] ;
+
+            num_queued = next_queued = 0 ;
+        }
+
+        queued_index = -1 ;
 
+        next_trial_poly( f, n, p, &constraints ) ;      /* Try another polynomal. */
+        ++num_poly ;
 
-    /* Constant coefficient of f(x) * (-1)^n must be a primitive root of p. */
-    if (const_coeff_is_primitive_root( f, n, p ))
+        #ifdef DEBUG_PP_PRIMPOLY
+        printf( "\nNext trial polynomial:  " ) ;
+        write_poly( f, n ) ;
+        printf( "\n" ) ;
+        #endif
+
+        /*                         n         2n-2
+            Precompute the powers x ,  ..., x     (mod f(x), p)
+            for use in all later computations.
+        */
+        construct_power_table( power_table, &gf3, f, n, p ) ;
+
+        /*  Primitive root constant, no linear factors, one irreducible factor. */
+        is_candidate = passes_prefilter( f, power_table, &gf3, n, p,
+                                         &num_const_coeff_prim_root,
+                                         &num_free_of_linear_factors,
+                                         &num_irred_to_power ) ;
+    }
+
+    /* x^r (mod f(x), p) = a must be an integer. */
+    if (is_candidate && order_r( power_table, &gf3, n, p, r, &a ))
     {
-        ++num_const_coeff_prim_root ;
+        ++num_order_r ;
 
         #ifdef DEBUG_PP_PRIMPOLY
-        printf( "Coefficient of polynomial is primitive root.\n" ) ;
+        printf( "Passes the order r test.\n" ) ;
         #endif
 
-        /* f(x) can't have any linear factors. */
-        if (!linear_factor( f, n, p ))
+        /*  Const coeff. of f(x)*(-1)^n must equal a mod p. */
+        if (const_coeff_test( f, n, p, a ))
         {
-            ++num_free_of_linear_factors ;
+            ++num_passing_const_coeff_test ;
 
             #ifdef DEBUG_PP_PRIMPOLY
-            printf( "Free of linear factors.\n" ) ;
+            printf( "Passes the constant coefficient test.\n" ) ;
             #endif
 
-            /* f(x) can't have two or more distinct irreducible factors. */
-            if (!has_multi_irred_factors( power_table, n, p ))
+            /*  x^m != integer for all m = r / q, q a prime divisor of r. */
+            if (order_m( power_table, &gf3, n, p, r, primes, prime_count ))
             {
-                ++num_irred_to_power ;
+                ++num_order_m ;
+                is_primitive_poly = YES ;
 
                 #ifdef DEBUG_PP_PRIMPOLY
-                printf( "Has one unique irreducible factor.\n" ) ;
+                printf( "Passes the order m tests.\n" ) ;
                 #endif
 
-                /* x^r (mod f(x), p) = a must be an integer. */
-                if (order_r( power_table, n, p, r, &a ))
+                if (listAllPrimitivePolynomials)
                 {
-                    ++num_order_r ;
-
-                     #ifdef DEBUG_PP_PRIMPOLY
-                     printf( "Passes the order r test.\n" ) ;
-                     #endif
-
-                     /*  Const coeff. of f(x)*(-1)^n must equal a mod p. */
-                     if (const_coeff_test( f, n, p, a ))
-                     {
-                         ++num_passing_const_coeff_test ;
-
-                         #ifdef DEBUG_PP_PRIMPOLY
-                         printf( "Passes the constant coefficient test.\n" ) ;
-                         #endif
-
-                         /*  x^m != integer for all m = r / q, q a prime divisor of r. */
-                         if (order_m( power_table, n, p, r, primes, prime_count ))
-                         {
-                             ++num_order_m ;
-                             is_primitive_poly = YES ;
-
-                             #ifdef DEBUG_PP_PRIMPOLY
-                             printf( "Passes the order m tests.\n" ) ;
-                             #endif
-
-                             if (listAllPrimitivePolynomials)
-                             {
-                                 printf( "\n\nPrimitive polynomial " ) ;
-                                 sprintf( outputFormat, "%s of %s ", bigintOutputFormat, bigintOutputFormat ) ;
-                                 printf(  outputFormat, ++prim_poly_count, num_prim_poly ) ;
-                                 printf( "modulo %d of degree %d\n\n", p, n ) ;
-                                 write_poly( f, n ) ;
-                                 printf( "\n\n" ) ;
-                             }
-                         }
-                     } /* end const coeff test */
-                } /* end order r */
-            } /* end can't determine if reducible */
-        } /* end no linear factors */
-    } /* end constant coefficient primitive. */
+                    printf( "\n\nPrimitive polynomial " ) ;
+
+                    /*  With constraints we don't know how many conform. */
+                    if (constraints.active)
+                        sprintf( outputFormat, "%s ", bigintOutputFormat ) ;
+                    else
+                        sprintf( outputFormat, "%s of %s ", bigintOutputFormat, bigintOutputFormat ) ;
+
+                    printf(  outputFormat, ++prim_poly_count, num_prim_poly ) ;
+                    printf( "modulo %d of degree %d\n\n", p, n ) ;
+                    write_poly( f, n ) ;
+                    printf( "\n\n" ) ;
+                }
+            }
+        } /* end const coeff test */
+    } /* end order r */
 
     /* Stop when we've either checked all possible polynomials or 
        we've not been asked to list all and found the first primtive one.  
     */
-    stopTesting = (num_poly > max_num_poly) || 
+    stopTesting = (next_queued >= num_queued && num_poly > max_num_poly) || 
                   (!listAllPrimitivePolynomials && is_primitive_poly) ;
 
-} while( !stopTesting ) ;
+}
+
+/*  Pre-filtering may have run past the primitive polynomial we stopped at.
+    Count only the polynomials up to it, as a search without the thread does,
+    so the statistics don't depend on thread timing.
+*/
+if (queued_index >= 0 && is_primitive_poly && !listAllPrimitivePolynomials)
+{
+    num_poly                   = queued_num_poly[ queued_index ] ;
+    num_const_coeff_prim_root  = queued_counts[ queued_index ][ 0 ] ;
+    num_free_of_linear_factors = queued_counts[ queued_index ][ 1 ] ;
+    num_irred_to_power         = queued_counts[ queued_index ][ 2 ] ;
+}
 
 printf( "\n\n" ) ;
 
@@ -454,7 +980,7 @@ printf( "\n\n" ) ;
      Report on success or failure.
 */
 
-if (listAllPrimitivePolynomials)
+if (listAllPrimitivePolynomials && is_primitive_poly)
     ; /* We're done */
 else if (is_primitive_poly)
 {
@@ -463,6 +989,12 @@ else if (is_primitive_poly)
     write_poly( f, n ) ;
     printf( "\n\n" ) ;
 }
+else if (constraints.active)
+{
+    printf( "No primitive polynomial modulo %d of degree %d satisfies the constraints.\n\n",
+            p, n ) ;
+    exit( 1 ) ;
+}
 else {
 
     printf( "Internal error:  \n"
@@ -58,6 +58,29 @@
     #define bigintOutputFormat "%lld" 
 #endif
 
+/* Storage for polynomial coefficients, which are residues 0 <= a < p.  Narrow
+   types keep the power table and Q matrix in a few cache lines and let the
+   compiler vectorize more of them per instruction;  all arithmetic on
+   residues is widened to int.  16-bit residues by default, enough for any p
+   whose products fit in an int.  Compile with -DPP_RESIDUE_BITS=8 when only
+   p < 256 is needed, or -DPP_RESIDUE_BITS=32 for int coefficients;  README.md
+   gives the build commands.
+*/
+#ifndef PP_RESIDUE_BITS
+#define PP_RESIDUE_BITS 16
+#endif
+
+#if PP_RESIDUE_BITS == 8
+    typedef unsigned char  residue ;
+    #define MAXRESIDUE 255
+#elif PP_RESIDUE_BITS == 16
+    typedef unsigned short residue ;
+    #define MAXRESIDUE 65535
+#else
+    typedef int            residue ;
+    #define MAXRESIDUE 2147483647
+#endif
+
 #define YES 1                      /*  Imitate boolean values. */
 #define NO  0
 
@@ -66,6 +89,14 @@
 #define _MAX_PATH 100
 #endif
 
+/* Factor r on a POSIX thread while the main thread pre-filters candidate 
+   polynomials.  Compile with -DPP_NO_THREADS to factor r up front instead. */
+#if !defined( _MSC_VER ) && !defined( PP_NO_THREADS )
+    #define PP_THREADS
+    #include <pthread.h>
+    #include <unistd.h>   /* for sysconf() */
+#endif
+
 
 /*==============================================================================
 |                            CONSTANTS
@@ -98,6 +129,124 @@
 #define NUM_PRIME_TEST_TRIALS 25 /*  Number of trials to test if a number is
 								     probably prime. */
 
+#define GFTABLEMAXP 256      /*  Use multiplication tables for primes p below
+                                 this.  The table holds p x p bytes.          */
+
+#define GFSHUFFLEMAXP 16     /*  ... and 16-way byte shuffles for p at most
+                                 this, when coefficients are 8 bits.          */
+
+
+/*  Factorization of an integer into distinct primes and their multiplicities,
+    primes in increasing order.
+*/
+typedef struct
+{
+    bigint primes[ MAXNUMPRIMEFACTORS ] ;  /*  Distinct prime factors.          */
+    int    count [ MAXNUMPRIMEFACTORS ] ;  /*  ... and their multiplicities.    */
+    int    num_primes ;                    /*  Number of distinct primes.       */
+} factorization ;
+
+
+/*  A polynomial mod 3 of degree < 64 as two bit planes:  bit k of one is set
+    when the coefficient of x^k is 1, bit k of two when it is 2.
+*/
+typedef struct
+{
+    bigint one ;
+    bigint two ;
+} gf3poly ;
+
+
+/*  The power table rows x^n, ..., x^2n-2 (mod f(x), 3) as bit planes.  The
+    caller owns one next to each power table and passes it along with the
+    table;  construct_power_table() fills it in for p = 3.  A null pointer,
+    or a table packed for another degree, means the generic routines.
+*/
+typedef struct
+{
+    int     n ;                        /*  Degree packed for, 0 if none.  */
+    gf3poly row[ MAXDEGPOLY - 1 ] ;    /*  The packed rows.               */
+} gf3table ;
+
+
+/*  Restrictions on the coefficients f[ i ] of the candidate polynomials:
+    each one is free, fixed to a value, or required to be nonzero, and the
+    number of nonzero terms may be bounded.
+*/
+#define FREE_COEFF     -1    /*  f[ i ] takes any value.                     */
+#define NONZERO_COEFF  -2    /*  f[ i ] takes the values 1, ..., p - 1.      */
+
+#define CONFLICTING_CONSTRAINT -1  /*  parse_constraint() found a restriction
+                                       contradicting an earlier one.        */
+#define INFEASIBLE_CONSTRAINT  -2  /*  Well formed, but together with the
+                                       others it leaves no polynomials.     */
+
+typedef struct
+{
+    int coeff[ MAXDEGPOLY ] ;  /*  Value of f[ i ], FREE_COEFF or NONZERO_COEFF. */
+    int max_weight ;           /*  Most nonzero terms, x^n included, 0 if any.   */
+    int active ;               /*  YES if there are any restrictions.            */
+} poly_constraints ;
+
+
+/*  Conway polynomials C (x) mod p for the degrees m found so far, and how.
+                        m
+*/
+#define CONWAY_BY_SEARCH 1   /*  Searched polynomials in Conway order.       */
+#define CONWAY_BY_ROOTS  2   /*  Enumerated compatible roots in GF(p^n).     */
+
+typedef struct
+{
+    int     found [ MAXDEGPOLY + 1 ] ;                   /*  YES once C is known.     */
+    int     method[ MAXDEGPOLY + 1 ] ;                   /*  How it was found.        */
+    bigint  tested[ MAXDEGPOLY + 1 ] ;                   /*  Candidates tried.        */
+    residue poly  [ MAXDEGPOLY + 1 ][ MAXDEGPOLY + 1 ] ; /*  Its coefficients.        */
+} conway_cache ;
+
+
+/*  A factor a(x) of a polynomial f(x) mod p:  monic, square free, dividing
+    f(x) to the given power, and the order of x modulo it.
+*/
+typedef struct
+{
+    residue poly[ MAXDEGPOLY + 1 ] ;  /*  Coefficients of a(x).                */
+    int     degree ;                  /*  Its degree.                          */
+    int     multiplicity ;            /*  Power of a(x) dividing f(x).         */
+    int     factor_degree ;           /*  Degree of each irreducible factor of
+                                          a(x), 0 if not yet known.           */
+    bigint  order ;                   /*  Order of x (mod a(x), p), 0 if not
+                                          yet known.                          */
+} poly_factor ;
+
+
+/*  A slice of a batch of candidate polynomials to test for irreducibility,
+    possibly on its own thread.
+*/
+typedef struct
+{
+    residue (* polys)[ MAXDEGPOLY + 1 ] ; /*  The whole batch.                 */
+    int *     is_irreducible ;            /*  YES or NO for each of them.      */
+    int       first ;                     /*  This slice is polys[ first ] ... */
+    int       last ;                      /*  ... polys[ last - 1 ].           */
+    int       n ;                         /*  Degree.                          */
+    int       p ;                         /*  Modulus.                         */
+} irreducible_job ;
+
+
+/*                       n
+    Factoring of p  - 1, possibly running on its own thread.
+*/
+typedef struct
+{
+    int             p ;       /*  Modulus.                                  */
+    int             n ;       /*  Degree.                                   */
+    factorization   pn1 ;     /*  The result, valid once done == YES.       */
+    int             done ;    /*  YES when factoring has finished.          */
+#ifdef PP_THREADS
+    pthread_mutex_t lock ;    /*  Guards done.                              */
+#endif
+} factoring_job ;
+
 
 /*==============================================================================
 |                            CONTROL PARAMETERS
@@ -109,6 +258,23 @@
 #define NUMTERMSPERLINE 7    /*  How many terms of a polynomial to 
                                  write before starting a new line.            */
 
+#define BERLEKAMP_MAXP 61    /*  Factor with Berlekamp's method for p up to
+                                 this and below the degree of the square free
+                                 part, Cantor-Zassenhaus otherwise.  From
+                                 Benchmark/ppBenchFactor:  Berlekamp wins
+                                 while p is below about the degree (p = 13
+                                 at n = 16, 31 at n = 48, 61 at n = 62).      */
+
+#define IRRED_BATCH_SIZE 4096 /*  Candidates generated at a time when listing
+                                  irreducible polynomials, split among the
+                                  threads.                                   */
+
+#define MAXTHREADS 16        /*  Most threads testing for irreducibility.    */
+
+#define PREFILTER_QUEUE_SIZE 256 /*  Most candidates which pass the first
+                                     tests while r is being factored that we
+                                     hold for the order tests.                */
+
 /*==============================================================================
 |                            F U N C T I O N S
 ==============================================================================*/
@@ -121,34 +287,47 @@ int parse_command_line( int    argc,
                         int *  printStatistics,
                         int *  printHelp,
                         int *  selfCheck,
+                        int *  conwayPolynomial,
+                        int *  orderOfPolynomial,
+                        int *  factorPolynomial,
+                        int *  irreduciblePolynomial,
                         int *  p,
                         int *  n,
-                        int *  testPolynomial ) ;
-void write_poly       ( int *  a, int n ) ;
+                        int *  testPolynomial,
+                        poly_constraints * constraints ) ;
+int  parse_constraint ( char * s, int n, int p, poly_constraints * constraints ) ;
+int  parse_poly       ( char * s, int n, int p, int * a ) ;
+void write_poly       ( residue * a, int n ) ;
 
 
 /* ppArith.c */
+extern int           gf_table_p ;  /* p for the tables below, 0 if none.  */
+extern int           gf_stride ;   /* Length of a row in gf_mul_table.    */
+extern unsigned char gf_mul_table[ GFTABLEMAXP * GFTABLEMAXP ] ;
+
 int    mod              ( int   n, int p ) ;
 bigint power            ( int   x, int y ) ;
 int    power_mod        ( int   a, int n, int p ) ;
 int    is_primitive_root( int   a, int p ) ;
 int    inverse_mod_p    ( int n, int p ) ;
+void   init_gf_tables   ( int p ) ;
 
 
 /* ppPolyArith.c */
-int  eval_poly            ( int *  f, int x, int n, int p ) ;
-int  linear_factor        ( int *  f, int n, int p ) ;
-int  is_integer           ( int *  t, int n ) ;
-void construct_power_table( int power_table[][ MAXDEGPOLY ], int * f, 
+int  eval_poly            ( residue * f, int x, int n, int p ) ;
+int  linear_factor        ( residue * f, int n, int p ) ;
+int  is_integer           ( residue * t, int n ) ;
+void construct_power_table( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, residue * f, 
                             int    n, int   p ) ;
-int  auto_convolve        ( int  * t, int   k, int   lower, int upper, int p ) ;
-int  convolve             ( int  * s, int * t, int   k, int   lower, int upper, int p ) ;
-int  coeff_of_square      ( int  * t, int   k, int   n, int p ) ;
-int  coeff_of_product     ( int  * s, int * t, int   k, int   n, int p ) ;
-void square               ( int  * t, int   power_table[][ MAXDEGPOLY ], int n, int p ) ;
-void product              ( int  * s, int * t, int   power_table[][ MAXDEGPOLY ], int n, int p ) ;
-void times_x              ( int  * t, int   power_table[][ MAXDEGPOLY ], int n, int p ) ;
-void x_to_power           ( bigint m, int * g, int power_table[][ MAXDEGPOLY ], int n, int p ) ;
+int  auto_convolve        ( residue * t, int   k, int   lower, int upper, int p ) ;
+int  convolve             ( residue * s, residue * t, int k, int lower, int upper, int p ) ;
+int  coeff_of_square      ( residue * t, int   k, int   n, int p ) ;
+int  coeff_of_product     ( residue * s, residue * t, int k, int n, int p ) ;
+void add_scaled_row       ( residue * t, residue * s, int c, int n, int p ) ;
+void square               ( residue * t, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p ) ;
+void product              ( residue * s, residue * t, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p ) ;
+void times_x              ( residue * t, residue power_table[][ MAXDEGPOLY ], int n, int p ) ;
+void x_to_power           ( bigint m, residue * g, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p ) ;
 
 
 /* ppFactor.c */
@@ -156,24 +335,69 @@ int    factor                ( bigint   n, bigint * primes, int * count ) ;
 int    is_probably_prime     ( int      n, int      x ) ;
 int    is_almost_surely_prime( int      n ) ;
 bigint EulerPhi              ( bigint   n ) ;
+void   factor_p_to_n_minus_1 ( int      p, int n, factorization * pn1 ) ;
+int    factor_r              ( factorization * pn1, int p, bigint * primes, int * count ) ;
+bigint EulerPhi_factored     ( factorization * f ) ;
+bigint num_irreducible       ( int      p, int n ) ;
+void * run_factoring_job     ( void * job ) ;
+int    factoring_done        ( factoring_job * job ) ;
 
 
 /* ppHelperFunc.c */
-void initial_trial_poly   ( int * f, int   n ) ;
-void next_trial_poly      ( int * f, int   n, int p ) ;
-int  const_coeff_test     ( int * f, int n, int p, int a ) ;
-int  const_coeff_is_primitive_root(  int * f, int n, int p ) ;
+void initial_trial_poly   ( residue * f, int   n, poly_constraints * c ) ;
+void next_trial_poly      ( residue * f, int   n, int p, poly_constraints * c ) ;
+bigint num_trial_polys    ( int   n, int p, poly_constraints * c ) ;
+int  const_coeff_test     ( residue * f, int n, int p, int a ) ;
+int  const_coeff_is_primitive_root(  residue * f, int n, int p ) ;
 int  skip_test            ( int   i, bigint * primes, int p ) ;
-void generate_Q_matrix    ( int **q, int power_table[][ MAXDEGPOLY ], int n, int p ) ;
-int  find_nullity         ( int ** Q, int n, int p ) ;
-int  has_multi_irred_factors ( int power_table[][ MAXDEGPOLY ], int n, int p ) ;
-
+void generate_Q_matrix    ( residue ** q, residue power_table[][ MAXDEGPOLY ], int n, int p ) ;
+int  find_nullity         ( residue ** Q, int n, int p ) ;
+int  has_multi_irred_factors ( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p ) ;
+int  passes_prefilter     ( residue * f, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p,
+                            int * num_const_coeff_prim_root,
+                            int * num_free_of_linear_factors,
+                            int * num_irred_to_power ) ;
+
+
+
+/* ppGF3.c */
+void gf3_pack_power_table ( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n ) ;
+int  gf3_has_power_table  ( gf3table * gf3, int n ) ;
+void gf3_x_to_power       ( bigint m, residue * g, gf3table * gf3, int n ) ;
+void gf3_product_residues ( residue * s, residue * t, gf3table * gf3, int n ) ;
+void gf3_square_residues  ( residue * t, gf3table * gf3, int n ) ;
+int  gf3_has_multi_irred_factors( gf3table * gf3, int n ) ;
+
+
+/* ppConway.c */
+int  conway_polynomial    ( int p, int n, residue * c, conway_cache * cache ) ;
+int  conway_less          ( residue * a, residue * b, int n, int p ) ;
+
+
+/* ppPolyFactor.c */
+int  poly_degree          ( residue * a, int n ) ;
+int  poly_divide          ( residue * a, int na, residue * b, int nb, 
+                            residue * q, residue * r, int p ) ;
+int  poly_gcd             ( residue * a, int na, residue * b, int nb, residue * g, int p ) ;
+void power_poly           ( residue * h, bigint e, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, 
+                            int n, int p ) ;
+int  square_free_factor   ( residue * f, int n, int p, poly_factor * factors ) ;
+int  distinct_degree_factor( poly_factor * a, int p, poly_factor * factors ) ;
+int  equal_degree_factor  ( poly_factor * a, int p, poly_factor * factors ) ;
+int  berlekamp_factor     ( poly_factor * a, int p, poly_factor * factors ) ;
+int  factor_poly          ( residue * f, int n, int p, poly_factor * factors ) ;
+int  is_factorization     ( residue * f, int n, int p, poly_factor * factors, int count ) ;
+int  is_irreducible       ( residue * f, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p ) ;
+void * run_irreducible_job( void * job ) ;
 
 
 /*  pporder.c */
-int  order_m      ( int power_table[][ MAXDEGPOLY ], int n, int p, bigint r, 
+int  order_m      ( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p, bigint r, 
                     bigint * primes, int prime_count ) ;
-int  order_r      ( int power_table[][ MAXDEGPOLY ], int n, int p, bigint r, int * a ) ;
-int  maximal_order( int * f, int n, int p ) ;
+int  order_r      ( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p, bigint r, int * a ) ;
+int  maximal_order( residue * f, int n, int p ) ;
+bigint order_of_x ( residue * f, int n, int p, int * pre_period, 
+                    poly_factor * factors, int * num_factors ) ;
+int  order_is_exact( residue * f, int n, int p, bigint e, int h ) ;
 
 #endif  /*  End of wrapper for header. */
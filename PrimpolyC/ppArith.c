@@ -14,6 +14,8 @@
 |      power
 |      power_mod
 |      is_primitive_root
+|      inverse_mod_p
+|      init_gf_tables
 |
 |  LEGAL
 |
@@ -44,6 +46,15 @@
 
 #include "Primpoly.h"
 
+
+/*  Multiplication table mod p for small primes.  gf_mul_table[ a * gf_stride + b ]
+    is a b (mod p) for 0 <= a, b < p, valid when gf_table_p = p.  Built once
+    per search by init_gf_tables() and only read afterwards.
+*/
+int           gf_table_p = 0 ;
+int           gf_stride  = 0 ;
+unsigned char gf_mul_table[ GFTABLEMAXP * GFTABLEMAXP ] ;
+
 /*==============================================================================
 |                                  mod                                         |
 ================================================================================
@@ -471,3 +482,86 @@ int inverse_mod_p( int u, int p )
 
 	return inv_v ;
 }
+
+
+
+/*==============================================================================
+|                               init_gf_tables                                 |
+================================================================================
+
+DESCRIPTION
+
+     Build the multiplication table mod p used by the polynomial arithmetic
+     in place of a division per product.
+
+INPUT
+
+     p      (int, p >= 2)  The prime modulus.
+
+OUTPUT
+
+     gf_table_p            p if p < GFTABLEMAXP, otherwise 0 and the table
+                           is not used.
+     gf_stride             Row length of the table:  16 for p <= GFSHUFFLEMAXP
+                           so a row can be loaded as one 16-byte shuffle
+                           control, p otherwise.
+     gf_mul_table          a b (mod p) at gf_mul_table[ a * gf_stride + b ],
+                           zero past column p-1.
+
+EXAMPLE
+
+     For p = 3, rows 0, 1, 2 of the table begin 0 0 0, 0 1 2, 0 2 1.
+
+METHOD
+
+     Each row is built by adding a, mod p, without any multiplies.  The table
+     has p x p bytes, at most 63 KB and 256 bytes for p <= 16, against two
+     divides per product in mod( mod( a * b, p ) + c, p ).
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void init_gf_tables( int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    a, b,          /*  Row and column.            */
+    ab ;           /*  a b (mod p).               */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (p >= GFTABLEMAXP)
+{
+    gf_table_p = 0 ;
+    return ;
+}
+
+gf_stride = (p <= GFSHUFFLEMAXP) ? 16 : p ;
+
+for (a = 0 ;  a < p ;  ++a)
+{
+    ab = 0 ;
+
+    for (b = 0 ;  b < gf_stride ;  ++b)
+    {
+        gf_mul_table[ a * gf_stride + b ] = (unsigned char)(b < p ? ab : 0) ;
+
+        if ((ab += a) >= p)
+            ab -= p ;
+    }
+}
+
+gf_table_p = p ;
+
+} /* ==================== end of function init_gf_tables ===================== */
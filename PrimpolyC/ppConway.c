@@ -0,0 +1,1093 @@
+/*==============================================================================
+|
+|  File Name:
+|
+|     ppConway.c
+|
+|  Description:
+|
+|     Conway polynomials:  the primitive polynomials of degree n modulo p
+|     which come first in the Conway ordering among those compatible with
+|     the Conway polynomials of all the proper divisors of n.
+|
+|  Functions:
+|
+|     conway_polynomial
+|     conway_less
+|     conway_candidates
+|     conway_search
+|     conway_by_roots
+|     conway_root_exponents
+|     min_poly
+|     compatible
+|     maximal_divisors
+|     least_primitive_root
+|     gcd_bigint
+|     crt
+|
+|  LEGAL
+|
+|     Primpoly Version 16.3 - A Program for Computing Primitive Polynomials.
+|     Copyright (C) 1999-2024 by Sean Erik O'Connor.  All Rights Reserved.
+|
+|     This program is free software: you can redistribute it and/or modify
+|     it under the terms of the GNU General Public License as published by
+|     the Free Software Foundation, either version 3 of the License, or
+|     (at your option) any later version.
+|
+|     This program is distributed in the hope that it will be useful,
+|     but WITHOUT ANY WARRANTY; without even the implied warranty of
+|     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+|     GNU General Public License for more details.
+|
+|     You should have received a copy of the GNU General Public License
+|     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+|
+|     The author's address is seanerikoconnor!AT!gmail!DOT!com
+|     with !DOT! replaced by . and the !AT! replaced by @
+|
+==============================================================================*/
+
+/*------------------------------------------------------------------------------
+|                                Include Files                                 |
+------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "Primpoly.h"
+
+
+/*                              n
+    The field GF(p^n) = GF(p)[x]/(F(x)) for a primitive F(x), in which the
+    roots method works, and for each divisor m of n the exponent e of a root
+        k e                                     n      m
+    of x     of C (x), where k = (p^n - 1)/(p^m - 1).
+                 m
+*/
+typedef struct
+{
+    int     p ;
+    int     n ;
+    bigint  pn1 ;                                         /* p ^ n - 1        */
+    residue power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ] ; /* Powers mod F(x)  */
+    gf3table gf3 ;                                        /* Same, for p = 3. */
+    residue trace[ MAXDEGPOLY ] ;                         /* Tr( x^j )        */
+    bigint  root_exp[ MAXDEGPOLY + 1 ] ;                  /* e, mod p^m - 1.  */
+} conway_field ;
+
+
+static int  conway_search   ( int p, int m, conway_cache * cache, int check_divisors,
+                              residue * c ) ;
+static int  conway_by_roots ( int p, int n, conway_cache * cache ) ;
+static int  conway_root_exponents( conway_field * field, int m, conway_cache * cache ) ;
+static int  compatible      ( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int m, int p,
+                              int * divisors, int num_divisors, conway_cache * cache ) ;
+
+
+/*==============================================================================
+|                                 conway_less                                  |
+================================================================================
+
+DESCRIPTION
+
+     Compare two monic polynomials of degree n in the Conway ordering.
+
+INPUT
+
+     a, b   (residue *)  Monic polynomials of degree n mod p.
+     n      (int)        Their degree.
+     p      (int)        Modulus.
+
+RETURNS
+
+     YES if a(x) comes strictly before b(x), NO otherwise.
+
+METHOD
+                                       n      n-1                   n
+     The Conway ordering writes f(x) = x  - s    x    + ... + (-1)  s
+                                             n-1                       0
+     and compares the digits s   , ..., s  lexicographically, each one in
+                              n-1        0
+     the order 0 < 1 < ... < p-1.  So s  = (-1)^(n-i) a  (mod p).
+                                       i                i
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int conway_less( residue * a, residue * b, int n, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    i,           /*  Loop counter.                 */
+    sa, sb ;     /*  Conway digits of a and b.     */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (i = n - 1 ;  i >= 0 ;  --i)
+{
+    sa = ((n - i) % 2) ? mod( -(int) a[ i ], p ) : a[ i ] ;
+    sb = ((n - i) % 2) ? mod( -(int) b[ i ], p ) : b[ i ] ;
+
+    if (sa != sb)
+        return (sa < sb) ? YES : NO ;
+}
+
+return NO ;
+
+} /* ===================== end of function conway_less ======================= */
+
+
+
+/*==============================================================================
+|                              maximal_divisors                                |
+================================================================================
+
+DESCRIPTION
+
+     The maximal proper divisors m / q of m, q a prime factor of m.
+
+INPUT
+
+     m  (int, m >= 1)
+
+OUTPUT
+
+     d  (int *)  The divisors in decreasing order.
+
+RETURNS
+
+     How many there are, 0 when m = 1.
+
+METHOD
+
+     Compatibility with C (x) for every proper divisor d of m follows from
+                          d
+     compatibility with these alone, since the norms compose:  if the norm
+     of a root of C  is a root of C  and d' | d, the norm of that to GF(p^d')
+                   m              d
+     is a root of C   by the compatibility of C  itself.
+                   d'                          d
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int maximal_divisors( int m, int * d )
+{
+    int q, k = 0, rest = m ;
+
+    for (q = 2 ;  q <= rest ;  ++q)
+
+        if (rest % q == 0)
+        {
+            d[ k++ ] = m / q ;
+
+            while (rest % q == 0)
+                rest /= q ;
+        }
+
+    return k ;
+
+} /* ================== end of function maximal_divisors ==================== */
+
+
+
+/*==============================================================================
+|                            least_primitive_root                              |
+================================================================================
+
+DESCRIPTION
+
+     The least primitive root w of p.  C (x) = x - w.
+                                       1
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int least_primitive_root( int p )
+{
+    int a ;
+
+    for (a = 1 ;  a < p ;  ++a)
+
+        if (is_primitive_root( a, p ))
+            return a ;
+
+    return 0 ;
+
+} /* ================ end of function least_primitive_root ================== */
+
+
+
+/*==============================================================================
+|                                  gcd_bigint                                  |
+================================================================================
+
+DESCRIPTION
+
+     Greatest common divisor by Euclid's algorithm;  gcd( 0, b ) = b.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static bigint gcd_bigint( bigint a, bigint b )
+{
+    bigint t ;
+
+    while (b != 0)
+    {
+        t = a % b ;  a = b ;  b = t ;
+    }
+
+    return a ;
+
+} /* ===================== end of function gcd_bigint ======================== */
+
+
+
+/*==============================================================================
+|                                     crt                                      |
+================================================================================
+
+DESCRIPTION
+
+     Chinese remaindering for moduli which need not be coprime:  combine
+     x = a1 (mod m1) and x = a2 (mod m2) into x = a (mod lcm( m1, m2 )).
+
+RETURNS
+
+     YES and a, m = lcm( m1, m2 ), or NO if the congruences are inconsistent.
+
+BUGS
+
+     The moduli are below 2^31, so no product overflows.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int crt( bigint a1, bigint m1, bigint a2, bigint m2, bigint * a, bigint * m )
+{
+    sbigint g = (sbigint) m1, h = (sbigint) m2, t,
+            u = 1, v = 0 ;        /*  u m1 = g (mod m2) throughout.  */
+
+    bigint  diff, step ;
+
+    while (h != 0)
+    {
+        t = g / h ;
+        g -= t * h ;  u -= t * v ;
+        t = g ;  g = h ;  h = t ;
+        t = u ;  u = v ;  v = t ;
+    }
+
+    diff = (a2 % m2 + m2 - a1 % m2) % m2 ;
+
+    if (diff % (bigint) g != 0)
+        return NO ;
+
+    step = m2 / (bigint) g ;
+    u    = u % (sbigint) step ;
+    if (u < 0)
+        u += (sbigint) step ;
+
+    *m = m1 * step ;
+    *a = (a1 + m1 * (((diff / (bigint) g) * (bigint) u) % step)) % *m ;
+
+    return YES ;
+
+} /* ========================== end of function crt ========================= */
+
+
+
+/*==============================================================================
+|                                   min_poly                                   |
+================================================================================
+
+DESCRIPTION
+
+     The minimal polynomial over GF(p) of an element b of GF(p^n) which lies
+     in the subfield GF(p^m).
+
+INPUT
+
+     b           (residue *)  The element, a polynomial of degree < n.
+     power_table (residue **) x ^ n, ..., x ^ 2n-2 (mod F(x), p).
+     gf3 (gf3table *) Its bit planes for p = 3, or NULL.
+     m, n, p     (int)
+
+OUTPUT
+
+     c           (residue *)  Its minimal polynomial, monic of degree m.
+
+RETURNS
+
+     YES, or NO if b has degree less than m.
+
+METHOD
+                                              m
+     Solve the linear system c  + c  b + ... b  = 0 over GF(p) for the
+                              0    1
+     c  by Gauss-Jordan elimination on the coefficients of the powers of b.
+      i
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int min_poly( residue * b, residue power_table[][ MAXDEGPOLY ], gf3table * gf3,
+                     int m, int n, int p, residue * c )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    a[ MAXDEGPOLY ][ MAXDEGPOLY + 1 ],  /*  Row j holds the coefficients of x^j
+                                            in 1, b, ..., b^(m-1) and -b^m.   */
+    bpow[ MAXDEGPOLY ],                 /*  b ^ i                             */
+    t ;
+
+int
+    i, j, k,                            /*  Loop counters.                    */
+    inv ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (j = 0 ;  j < n ;  ++j)
+    bpow[ j ] = (j == 0) ;
+
+for (i = 0 ;  i <= m ;  ++i)
+{
+    for (j = 0 ;  j < n ;  ++j)
+        a[ j ][ i ] = (i < m) ? bpow[ j ] : (residue) mod( -(int) bpow[ j ], p ) ;
+
+    if (i < m)
+        product( bpow, b, power_table, gf3, n, p ) ;
+}
+
+/*  Row i becomes the pivot row for column i. */
+for (i = 0 ;  i < m ;  ++i)
+{
+    for (j = i ;  j < n && a[ j ][ i ] == 0 ;  ++j)
+        ;
+
+    if (j == n)
+        return NO ;
+
+    for (k = i ;  k <= m ;  ++k)
+    {
+        t = a[ j ][ k ] ;  a[ j ][ k ] = a[ i ][ k ] ;  a[ i ][ k ] = t ;
+    }
+
+    if ((inv = inverse_mod_p( a[ i ][ i ], p )) != 1)
+
+        for (k = i ;  k <= m ;  ++k)
+            a[ i ][ k ] = (residue)(((bigint) a[ i ][ k ] * inv) % p) ;
+
+    for (j = 0 ;  j < n ;  ++j)
+
+        if (j != i && (t = a[ j ][ i ]) != 0)
+
+            add_scaled_row( &a[ j ][ i ], &a[ i ][ i ], p - t, m + 1 - i, p ) ;
+}
+
+for (i = 0 ;  i < m ;  ++i)
+    c[ i ] = a[ i ][ m ] ;
+
+c[ m ] = 1 ;
+
+return YES ;
+
+} /* ====================== end of function min_poly ======================== */
+
+
+
+/*==============================================================================
+|                                 compatible                                   |
+================================================================================
+
+DESCRIPTION
+
+     Test a primitive f(x) of degree m for compatibility with the Conway
+     polynomials of the maximal proper divisors d of m other than 1.
+
+INPUT
+
+     power_table  (residue **)  x ^ m, ..., x ^ 2m-2 (mod f(x), p).
+     divisors     (int *)       The divisors d.
+     cache        (conway_cache *)  Holds C (x) for each of them.
+                                      d
+RETURNS
+                     k                                   m      d
+     YES if each C (x ) = 0 (mod f(x), p), where k = (p^m - 1)/(p^d - 1),
+                  d
+     NO otherwise.
+
+METHOD
+                                    k
+     For a root a of f(x), a  = x (mod f(x), p) and a  = a  is its norm
+                                                   d
+     to GF(p^d).  Evaluate C  at it by Horner's rule.
+                            d
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int compatible( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int m, int p,
+                       int * divisors, int num_divisors, conway_cache * cache )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    i, j, k,      /*  Loop counters.                  */
+    d ;           /*  Degree of the subfield.         */
+
+residue
+    g[ MAXDEGPOLY ],  /*  x ^ k (mod f(x), p)         */
+    h[ MAXDEGPOLY ] ; /*  C (g(x)) by Horner's rule.  */
+                      /*   d                          */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (i = 0 ;  i < num_divisors ;  ++i)
+{
+    if ((d = divisors[ i ]) == 1)
+        continue ;
+
+    x_to_power( (power( p, m ) - 1) / (power( p, d ) - 1), g, power_table, gf3, m, p ) ;
+
+    for (j = 0 ;  j < m ;  ++j)
+        h[ j ] = (j == 0) ;
+
+    for (k = d - 1 ;  k >= 0 ;  --k)
+    {
+        product( h, g, power_table, gf3, m, p ) ;
+        h[ 0 ] = (residue)(((int) h[ 0 ] + cache->poly[ d ][ k ]) % p) ;
+    }
+
+    for (j = 0 ;  j < m ;  ++j)
+
+        if (h[ j ] != 0)
+            return NO ;
+}
+
+return YES ;
+
+} /* ===================== end of function compatible ======================== */
+
+
+
+/*==============================================================================
+|                                conway_search                                 |
+================================================================================
+
+DESCRIPTION
+
+     Find C (x) by testing polynomials of degree m in the Conway ordering.
+           m
+INPUT
+
+     p, m            (int)           Modulus and degree, m >= 2.
+     cache           (conway_cache *) C (x) for the maximal proper divisors
+                                       d
+                                     d of m, when check_divisors is YES.
+     check_divisors  (int)           NO to stop at the first primitive
+                                     polynomial with the right constant term.
+OUTPUT
+
+     c               (residue *)     The polynomial found.
+
+RETURNS
+
+     YES if found, NO if we ran out of polynomials.
+
+METHOD
+                                          r                         m
+     The norm of a root a of f(x) to GF(p) is a  = (-1)^m a , r = (p  - 1)/(p - 1),
+                                                           0
+     which compatibility with C (x) = x - w makes w.  So the last Conway
+                               1
+     digit s  = w and we only count through the others.  Each candidate
+            0
+     goes through the same tests as in main(), with the compatibility test
+     ahead of the order tests, since it rejects nearly everything.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int conway_search( int p, int m, conway_cache * cache, int check_divisors,
+                          residue * c )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+factorization
+    pm1 ;                          /* p ^ m - 1 factored.                    */
+
+bigint
+    r = (power( p, m ) - 1) / (p - 1),
+    primes[ MAXNUMPRIMEFACTORS ],  /* The distinct prime factors of r.       */
+    tested = 0 ;                   /* Polynomials tried.                     */
+
+int
+    count[ MAXNUMPRIMEFACTORS ],   /* ... and their multiplicities.          */
+    prime_count,
+    divisors[ MAXNUMPRIMEFACTORS ],
+    num_divisors = 0,
+    s[ MAXDEGPOLY + 1 ],           /* Conway digits of f(x).                 */
+    a = 0,                         /* Integer in the order r test.           */
+    i,
+    num_const_coeff_prim_root  = 0,
+    num_free_of_linear_factors = 0,
+    num_irred_to_power         = 0 ;
+
+residue
+    f[ MAXDEGPOLY + 1 ],
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+factor_p_to_n_minus_1( p, m, &pm1 ) ;
+prime_count = factor_r( &pm1, p, primes, count ) ;
+
+if (check_divisors)
+    num_divisors = maximal_divisors( m, divisors ) ;
+
+for (i = 1 ;  i < m ;  ++i)
+    s[ i ] = 0 ;
+
+s[ 0 ] = least_primitive_root( p ) ;
+
+for (;;)
+{
+    for (i = 0 ;  i < m ;  ++i)
+        f[ i ] = (residue)(((m - i) % 2) ? mod( -s[ i ], p ) : s[ i ]) ;
+
+    f[ m ] = 1 ;
+    ++tested ;
+
+    construct_power_table( power_table, &gf3, f, m, p ) ;
+
+    if (passes_prefilter( f, power_table, &gf3, m, p,
+                          &num_const_coeff_prim_root,
+                          &num_free_of_linear_factors,
+                          &num_irred_to_power )                               &&
+        compatible( power_table, &gf3, m, p, divisors, num_divisors, cache )       &&
+        order_r( power_table, &gf3, m, p, r, &a )                                  &&
+        const_coeff_test( f, m, p, a )                                       &&
+        order_m( power_table, &gf3, m, p, r, primes, prime_count ))
+    {
+        for (i = 0 ;  i <= m ;  ++i)
+            c[ i ] = f[ i ] ;
+
+        if (check_divisors)
+            cache->tested[ m ] += tested ;
+
+        return YES ;
+    }
+
+    /*  Next digits s    ... s , s  fixed. */
+    /*               m-1      1   0        */
+    for (i = 1 ;  i < m && ++s[ i ] == p ;  ++i)
+        s[ i ] = 0 ;
+
+    if (i == m)
+        return NO ;
+}
+
+} /* =================== end of function conway_search ====================== */
+
+
+
+/*==============================================================================
+|                            conway_root_exponents                             |
+================================================================================
+
+DESCRIPTION
+                                            n                k e
+     For a divisor m of n, find C (x) and the exponent e with x     one of
+                                 m
+                                n      m
+     its roots in GF(p^n), k = (p  - 1)/(p  - 1), given the same for all the
+     divisors of m.
+
+INPUT
+
+     field  (conway_field *)  GF(p^n), and the exponents found so far.
+     m      (int)             m | n.
+
+OUTPUT
+
+     cache  (conway_cache *)  C (x), and how many candidates we tried.
+                               m
+RETURNS
+
+     YES if found, NO on internal error.
+
+METHOD
+                                      n                        m
+     x generates GF(p^n)*, so y = x^k generates GF(p^m)*, and C (x) is the
+                                                               m
+     minimal polynomial of some primitive y^e.  The norm of y^e to GF(p^d)
+     is the image of e mod p^d - 1, so C  is compatible with C  exactly when
+                                        m                      d
+     e = e  p^j (mod p^d - 1) for one of the d conjugate roots of C .  Up to
+          d                                                       d
+     conjugation of y^e itself we can take j = 0 for the first divisor.
+     Chinese remaindering each choice of conjugates leaves a few residues
+     e  mod L = lcm( p^d - 1 ), and we take the minimal polynomial of each
+      0
+     e = e  + t L coprime to p^m - 1, keeping the first in Conway ordering.
+          0
+     Stepping e by L costs one product.  The first Conway digit is the trace
+     to GF(p), which is linear, so when p doesn't divide n/m we skip the
+     elimination in min_poly() for candidates whose trace is already too big.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int conway_root_exponents( conway_field * field, int m, conway_cache * cache )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    p = field->p,
+    n = field->n,
+    divisors[ MAXNUMPRIMEFACTORS ],
+    choice[ MAXNUMPRIMEFACTORS ],    /* Conjugate p^j chosen for each divisor. */
+    num_divisors,
+    found = NO,
+    first_digit = 0,                 /* Of the best so far.                    */
+    scale,                           /* Tr to GF(p^m) is Tr / (n/m), or 0      */
+    i, j ;                           /* when p | n/m.                          */
+
+bigint
+    q = power( p, m ) - 1,           /* Order of GF(p^m)*.                     */
+    k = field->pn1 / q,
+    e0, L, e, qd, a,
+    tr ;                             /* Trace of x ^ (k e).                    */
+
+residue
+    y[ MAXDEGPOLY ],                 /* x ^ (k e) (mod F(x), p)                */
+    step[ MAXDEGPOLY ],              /* x ^ (k L)                              */
+    c[ MAXDEGPOLY + 1 ],             /* Its minimal polynomial.                */
+    best[ MAXDEGPOLY + 1 ] ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+num_divisors = maximal_divisors( m, divisors ) ;
+
+scale = ((n / m) % p) ? inverse_mod_p( (n / m) % p, p ) : 0 ;
+
+for (i = 0 ;  i < num_divisors ;  ++i)
+    choice[ i ] = 0 ;
+
+for (;;)
+{
+    /*  Chinese remainder one choice of conjugates. */
+    e0 = 0 ;
+    L  = 1 ;
+
+    for (i = 0 ;  i < num_divisors ;  ++i)
+    {
+        qd = power( p, divisors[ i ] ) - 1 ;
+        a  = field->root_exp[ divisors[ i ] ] % qd ;
+
+        for (j = 0 ;  j < choice[ i ] ;  ++j)
+            a = (a * p) % qd ;
+
+        if (!crt( e0, L, a, qd, &e0, &L ))
+            break ;
+    }
+
+    /*  Step through e = e0 + t L, multiplying by x^(k L) each time. */
+    if (i == num_divisors)
+    {
+        if (e0 == 0)
+        {
+            for (j = 0 ;  j < n ;  ++j)
+                y[ j ] = (j == 0) ;
+        }
+        else
+            x_to_power( k * e0, y, field->power_table, &field->gf3, n, p ) ;
+
+        if (L < q)
+            x_to_power( k * L, step, field->power_table, &field->gf3, n, p ) ;
+
+        for (e = e0 ;  e < q ;  e += L)
+        {
+            if (e != e0)
+                product( y, step, field->power_table, &field->gf3, n, p ) ;
+
+            if (gcd_bigint( e, q ) != 1)  /*  Only e = 0 for q = 1.  */
+                continue ;
+
+            ++cache->tested[ m ] ;
+
+            /*  Its first Conway digit is its trace;  skip it if that's
+                already too big. */
+            if (found && scale)
+            {
+                for (tr = 0, j = 0 ;  j < n ;  ++j)
+                    tr += (bigint) y[ j ] * field->trace[ j ] ;
+
+                if ((int)(tr % p) * scale % p > first_digit)
+                    continue ;
+            }
+
+            if (!min_poly( y, field->power_table, &field->gf3, m, n, p, c ))
+                return NO ;
+
+            if (!found || conway_less( c, best, m, p ))
+            {
+                for (j = 0 ;  j <= m ;  ++j)
+                    best[ j ] = c[ j ] ;
+
+                field->root_exp[ m ] = e ;
+                first_digit = mod( -(int) best[ m - 1 ], p ) ;
+                found = YES ;
+            }
+        }
+    }
+
+    /*  Next choice of conjugates, the first divisor's held fixed. */
+    for (i = 1 ;  i < num_divisors && ++choice[ i ] == divisors[ i ] ;  ++i)
+        choice[ i ] = 0 ;
+
+    if (i >= num_divisors)
+        break ;
+}
+
+if (!found)
+    return NO ;
+
+for (j = 0 ;  j <= m ;  ++j)
+    cache->poly[ m ][ j ] = best[ j ] ;
+
+cache->found [ m ] = YES ;
+cache->method[ m ] = CONWAY_BY_ROOTS ;
+
+return YES ;
+
+} /* =============== end of function conway_root_exponents ================== */
+
+
+
+/*==============================================================================
+|                                conway_by_roots                               |
+================================================================================
+
+DESCRIPTION
+
+     Find C (x) for every divisor m of n, n included, by their roots in one
+           m
+     field GF(p^n).
+
+INPUT
+
+     p, n   (int)
+
+OUTPUT
+
+     cache  (conway_cache *)  C (x) for all m | n.
+                               m
+RETURNS
+
+     YES if found, NO on internal error.
+
+METHOD
+
+     Build GF(p^n) from the first primitive polynomial with the right
+     constant term, then run conway_root_exponents() on the divisors of n
+     from the smallest up, so each one finds the root exponents of its own
+     divisors already known.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static int conway_by_roots( int p, int n, conway_cache * cache )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+conway_field
+    field ;
+
+residue
+    F[ MAXDEGPOLY + 1 ] ;  /*  Defines the field.  */
+
+int
+    m, i, j,
+    tr ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (!conway_search( p, n, cache, NO, F ))
+    return NO ;
+
+field.p   = p ;
+field.n   = n ;
+field.pn1 = power( p, n ) - 1 ;
+
+/*  Powers of x modulo F(x) for the arithmetic in GF(p^n). */
+construct_power_table( field.power_table, &field.gf3, F, n, p ) ;
+
+/*                                                          j
+    Traces to GF(p) of the basis, the trace of the map z -> x  z.
+*/
+for (j = 0 ;  j < n ;  ++j)
+{
+    tr = (j == 0) ? n % p : 0 ;
+
+    for (i = n - j ;  i < n ;  ++i)
+        tr = (tr + field.power_table[ i + j - n ][ i ]) % p ;
+
+    field.trace[ j ] = (residue) tr ;
+}
+
+for (m = 1 ;  m <= n ;  ++m)
+
+    if (n % m == 0 && !conway_root_exponents( &field, m, cache ))
+        return NO ;
+
+return YES ;
+
+} /* ================== end of function conway_by_roots ===================== */
+
+
+
+/*==============================================================================
+|                              conway_candidates                               |
+================================================================================
+
+DESCRIPTION
+
+     Roughly how many minimal polynomials conway_root_exponents() computes
+     for C (x):  (p^m - 1) / lcm( p^d - 1 ) for each choice of conjugates,
+           m
+     over the maximal divisors d of m.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static double conway_candidates( int p, int m )
+{
+    int    divisors[ MAXNUMPRIMEFACTORS ], num_divisors, i ;
+    bigint L = 1, e0 = 0, qd ;
+    double choices = 1.0 ;
+
+    num_divisors = maximal_divisors( m, divisors ) ;
+
+    for (i = 0 ;  i < num_divisors ;  ++i)
+    {
+        qd = power( p, divisors[ i ] ) - 1 ;
+        crt( e0, L, 0, qd, &e0, &L ) ;
+
+        if (i > 0)
+            choices *= divisors[ i ] ;
+    }
+
+    return choices * (double)((power( p, m ) - 1) / L) ;
+
+} /* ================= end of function conway_candidates ==================== */
+
+
+
+/*==============================================================================
+|                              conway_polynomial                               |
+================================================================================
+
+DESCRIPTION
+
+     Find the Conway polynomial C (x) of degree n modulo p.
+                                 n
+INPUT
+
+     p      (int)             Prime modulus.
+     n      (int, n >= 1)     Degree.
+     cache  (conway_cache *)  Conway polynomials found by earlier calls for
+                              this p;  all zero the first time.
+
+OUTPUT
+
+     c      (residue *)       C (x), monic of degree n.
+                               n
+     cache  (conway_cache *)  Now holds C (x) for n and every divisor of n
+                                         d
+                              we had to find along the way, with the
+                              method and the number of candidates tried.
+
+RETURNS
+
+     YES if found, NO on internal error.
+
+EXAMPLE
+                                 6    4    3
+     Let p = 2 and n = 6.  C (x) = x  + x  + x  + x + 1, the first primitive
+                            6
+                                                                       3
+     polynomial in the Conway ordering whose root a has a^9 a root of x + x + 1
+                  2
+     and a^21 of x  + x + 1.
+
+METHOD
+
+     C (x) is the first primitive polynomial f(x) in the Conway ordering
+      n
+     whose roots a have norms a^((p^n - 1)/(p^d - 1)) to each subfield
+     GF(p^d), d | n, d < n, which are roots of C (x).  There are two ways
+                                               d
+     to find it:
+
+     Search the polynomials in Conway order, testing for primitivity and
+     compatibility with the maximal proper divisors, found recursively.
+     The compatible ones are scarce when n has large divisors.
+
+     Or enumerate the roots:  compatibility pins down the discrete logs of
+     the roots mod lcm( p^d - 1 ) up to conjugates, which leaves few of them
+     when the divisors are large, but all but a factor p - 1 when n is prime.
+
+     We pick whichever should try fewer candidates:  search expects about
+     p^(n-1) n / (compatible roots) polynomials before its first hit.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int conway_polynomial( int p, int n, residue * c, conway_cache * cache )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    divisors[ MAXNUMPRIMEFACTORS ] = { 1 },
+    num_divisors,
+    i, m ;
+
+double
+    by_roots  = 0.0,      /*  Estimated candidates for each method.  */
+    by_search ;
+
+residue
+    sub[ MAXDEGPOLY + 1 ] ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (!cache->found[ n ])
+{
+    if (n == 1)
+    {
+        cache->poly[ 1 ][ 0 ] = (residue) mod( -least_primitive_root( p ), p ) ;
+        cache->poly[ 1 ][ 1 ] = 1 ;
+        cache->method[ 1 ]    = CONWAY_BY_SEARCH ;
+        cache->tested[ 1 ]    = 1 ;
+        cache->found [ 1 ]    = YES ;
+    }
+    else
+    {
+        num_divisors = maximal_divisors( n, divisors ) ;
+
+        for (m = 1 ;  m <= n ;  ++m)
+            if (n % m == 0)
+                by_roots += conway_candidates( p, m ) ;
+
+        by_search = pow( (double) p, (double)(n - 1) ) * n /
+                    (conway_candidates( p, n ) * divisors[ 0 ]) ;
+
+        if (by_roots <= by_search)
+        {
+            if (!conway_by_roots( p, n, cache ))
+                return NO ;
+        }
+        else
+        {
+            for (i = 0 ;  i < num_divisors ;  ++i)
+                if (!conway_polynomial( p, divisors[ i ], sub, cache ))
+                    return NO ;
+
+            if (!conway_search( p, n, cache, YES, cache->poly[ n ] ))
+                return NO ;
+
+            cache->method[ n ] = CONWAY_BY_SEARCH ;
+            cache->found [ n ] = YES ;
+        }
+    }
+}
+
+for (i = 0 ;  i <= n ;  ++i)
+    c[ i ] = cache->poly[ n ][ i ] ;
+
+return YES ;
+
+} /* ================= end of function conway_polynomial ==================== */
@@ -11,6 +11,12 @@
 |  Functions:
 |
 |     factor
+|     factor_p_to_n_minus_1
+|     factor_r
+|     EulerPhi_factored
+|     num_irreducible
+|     run_factoring_job
+|     factoring_done
 |     is_probably_prime
 |     is_almost_surely_prime
 |
@@ -370,6 +376,476 @@ EulerPhi( bigint n )
 }
 
 
+/*==============================================================================
+|                            factor_p_to_n_minus_1                             |
+================================================================================
+
+DESCRIPTION
+
+                     n
+     Factor the integer p  - 1 into distinct primes, once, for all later uses.
+
+INPUT
+
+     p      (int, p >= 2)     Prime modulus.
+     n      (int, n >= 2)     Degree.
+
+OUTPUT
+                                                  n
+     pn1    (factorization *) The factorization of p  - 1, primes in
+                              increasing order.
+
+EXAMPLE
+                   4                 4
+     For p = 5, n = 4, 5  - 1 = 624 = 2  3 13:
+
+     k   primes[ k ]   count[ k ]
+     ----------------------------
+     0        2            4
+     1        3            1
+     2       13            1
+
+METHOD
+             n                         n
+     Since p  - 1 = (p - 1) r where r = (p  - 1) / (p - 1), we factor the
+     small number p - 1 and the number r (which we must factor anyway for the
+     order tests), and merge the two lists of primes, adding multiplicities of
+     the primes they have in common.  This replaces factoring the much larger
+      n
+     p  - 1 from scratch, which is what EulerPhi() would do.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void factor_p_to_n_minus_1( int p, int n, factorization * pn1 )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+bigint
+    r,                              /*  (p^n - 1)/(p - 1)                  */
+    r_primes[ MAXNUMPRIMEFACTORS ], /*  Factors of r.                      */
+    p_primes[ MAXNUMPRIMEFACTORS ] ;/*  Factors of p - 1.                  */
+
+int
+    r_count[ MAXNUMPRIMEFACTORS ],
+    p_count[ MAXNUMPRIMEFACTORS ],
+    r_num = 0,                      /*  Number of distinct primes of r.    */
+    p_num = 0,                      /*  Number of distinct primes of p - 1.*/
+    i = 0,
+    j = 0 ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+r = (power( p, n ) - 1) / (p - 1) ;
+
+/*  factor() reports 1 as the single "prime" 1;  leave such lists empty. */
+if (r > 1)
+    r_num = factor( r, r_primes, r_count ) + 1 ;
+
+if (p > 2)
+    p_num = factor( (bigint)(p - 1), p_primes, p_count ) + 1 ;
+
+
+/*  Merge the two sorted lists of primes. */
+pn1->num_primes = 0 ;
+
+while (i < r_num || j < p_num)
+{
+    if (j >= p_num || (i < r_num && r_primes[ i ] < p_primes[ j ]))
+    {
+        pn1->primes[ pn1->num_primes ] = r_primes[ i ] ;
+        pn1->count [ pn1->num_primes ] = r_count[ i++ ] ;
+    }
+    else if (i >= r_num || p_primes[ j ] < r_primes[ i ])
+    {
+        pn1->primes[ pn1->num_primes ] = p_primes[ j ] ;
+        pn1->count [ pn1->num_primes ] = p_count[ j++ ] ;
+    }
+    else
+    {
+        pn1->primes[ pn1->num_primes ] = r_primes[ i ] ;
+        pn1->count [ pn1->num_primes ] = r_count[ i++ ] + p_count[ j++ ] ;
+    }
+
+    ++pn1->num_primes ;
+}
+
+} /* ================= end of function factor_p_to_n_minus_1 ================ */
+
+
+
+/*==============================================================================
+|                                  factor_r                                    |
+================================================================================
+
+DESCRIPTION
+                                                      n
+     Derive the factorization of r = (p^n - 1)/(p - 1) from that of p  - 1,
+     in the form returned by factor().
+
+INPUT
+                                                  n
+     pn1    (factorization *) The factorization of p  - 1.
+     p      (int, p >= 2)     Prime modulus.
+
+OUTPUT
+
+     primes (bigint *)   List of distinct prime factors of r.
+     count  (int *)      List of how many times each factor occurred.
+
+     When r = 1, primes[ 0 ] = count[ 0 ] = 1, as for factor().
+
+RETURNS
+
+     t (int)             Number of prime factors of r - 1.
+
+METHOD
+
+     Subtract from each multiplicity the number of times the prime divides
+     p - 1, and drop the primes whose multiplicity becomes zero.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int factor_r( factorization * pn1, int p, bigint * primes, int * count )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    i,
+    t = 0,              /*  Number of primes of r so far.            */
+    multiplicity,       /*  Multiplicity of a prime in r.            */
+    pm1 ;               /*  What remains of p - 1.                   */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+pm1 = p - 1 ;
+
+for (i = 0 ;  i < pn1->num_primes ;  ++i)
+{
+    multiplicity = pn1->count[ i ] ;
+
+    while (pm1 % pn1->primes[ i ] == 0)
+    {
+        pm1 /= pn1->primes[ i ] ;
+        --multiplicity ;
+    }
+
+    if (multiplicity > 0)
+    {
+        primes[ t ] = pn1->primes[ i ] ;
+        count[ t++ ] = multiplicity ;
+    }
+}
+
+if (t == 0)
+{
+    primes[ 0 ] = count[ 0 ] = 1 ;
+    return( 0 ) ;
+}
+
+return( t - 1 ) ;
+
+} /* ======================= end of function factor_r ======================== */
+
+
+
+/*==============================================================================
+|                              EulerPhi_factored                               |
+================================================================================
+
+DESCRIPTION
+
+     Euler's totient function of an integer given by its factorization.
+
+INPUT
+
+     f      (factorization *) Factorization of n >= 1.
+
+RETURNS
+                                              e  - 1
+                                               i
+     phi( n ) (bigint)   The product of  p         (p  - 1) over the primes p
+                                          i          i                     i
+                         of multiplicity e .
+                                          i
+EXAMPLE
+                   4
+     For n = 624 = 2  3 13, phi( n ) = 8 * 2 * 12 = 192.
+
+METHOD
+
+     No factoring:  that has been done once already.  Unlike EulerPhi(), the
+     formula above never has intermediate results greater than n.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+bigint EulerPhi_factored( factorization * f )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    i,
+    k ;
+
+bigint
+    phi = 1 ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (i = 0 ;  i < f->num_primes ;  ++i)
+{
+    phi *= f->primes[ i ] - 1 ;
+
+    for (k = 1 ;  k < f->count[ i ] ;  ++k)
+        phi *= f->primes[ i ] ;
+}
+
+return phi ;
+
+} /* ================== end of function EulerPhi_factored ==================== */
+
+
+
+/*==============================================================================
+|                               num_irreducible                                |
+================================================================================
+
+DESCRIPTION
+
+     The number of monic irreducible polynomials of degree n modulo p.
+
+INPUT
+
+     p      (int)             Prime modulus.
+     n      (int, n >= 1)     Degree.
+
+RETURNS
+                       1                 n/d
+     I( p, n ) =      ---   sum   mu(d) p
+                       n    d | n
+
+     where mu is the Moebius function.  The same formula counts the
+     aperiodic necklaces of n beads in p colors.
+
+EXAMPLE
+
+     For p = 2, n = 4, I = (16 - 4) / 4 = 3:  x^4 + x + 1, x^4 + x^3 + 1
+     and x^4 + x^3 + x^2 + x + 1.
+
+METHOD
+                                         n/d
+     Sum the terms with mu(d) = +1 and -p    separately so nothing goes
+                                                       n
+     negative;  no intermediate result is more than p .
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+bigint num_irreducible( int p, int n )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    d,                   /*  Divisor of n.                       */
+    m,                   /*  What is left of d to factor.        */
+    q,                   /*  Trial prime divisor of d.           */
+    mu ;                 /*  Moebius function of d.              */
+
+bigint
+    plus  = 0,           /*  Sum of the terms with mu = +1.      */
+    minus = 0 ;          /*  ... and with mu = -1.               */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (d = 1 ;  d <= n ;  ++d)
+{
+    if (n % d != 0)
+        continue ;
+
+    for (mu = 1, m = d, q = 2 ;  q <= m ;  ++q)
+    {
+        if (m % q == 0)
+        {
+            m /= q ;
+            mu = -mu ;
+
+            /*  Square factor. */
+            if (m % q == 0)
+            {
+                mu = 0 ;
+                break ;
+            }
+        }
+    }
+
+    if (mu > 0)
+        plus  += power( p, n / d ) ;
+    else if (mu < 0)
+        minus += power( p, n / d ) ;
+}
+
+return (plus - minus) / n ;
+
+} /* =================== end of function num_irreducible ===================== */
+
+
+
+/*==============================================================================
+|                             run_factoring_job                                |
+================================================================================
+
+DESCRIPTION
+                 n
+     Factor p  - 1 for a factoring job and mark the job done.  Has the
+     signature of a POSIX thread start routine so main() can run it
+     alongside the search for candidate polynomials.
+
+INPUT
+
+     job    (factoring_job *)  p and n set, done = NO.
+
+OUTPUT
+
+     job    (factoring_job *)  pn1 filled in, done = YES.
+
+RETURNS
+
+     NULL.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void * run_factoring_job( void * job )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+factoring_job * fj = (factoring_job *) job ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+factor_p_to_n_minus_1( fj->p, fj->n, &fj->pn1 ) ;
+
+#ifdef PP_THREADS
+pthread_mutex_lock( &fj->lock ) ;
+#endif
+
+fj->done = YES ;
+
+#ifdef PP_THREADS
+pthread_mutex_unlock( &fj->lock ) ;
+#endif
+
+return NULL ;
+
+} /* ================== end of function run_factoring_job =================== */
+
+
+
+/*==============================================================================
+|                               factoring_done                                 |
+================================================================================
+
+DESCRIPTION
+
+     Poll whether a factoring job has finished.
+
+INPUT
+
+     job    (factoring_job *)  
+
+RETURNS
+
+     YES if job->pn1 is ready, NO otherwise.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int factoring_done( factoring_job * job )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int done ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+#ifdef PP_THREADS
+pthread_mutex_lock( &job->lock ) ;
+#endif
+
+done = job->done ;
+
+#ifdef PP_THREADS
+pthread_mutex_unlock( &job->lock ) ;
+#endif
+
+return done ;
+
+} /* ==================== end of function factoring_done ===================== */
+
+
+
 /*==============================================================================
 |                             is_probably_prime                                |
 ================================================================================
@@ -0,0 +1,591 @@
+/*==============================================================================
+|
+|  File Name:
+|
+|     ppGF3.c
+|
+|  Description:
+|
+|     Bit-sliced polynomial arithmetic modulo 3.  A polynomial of degree < 64
+|     is held as two bit planes:  bit k of one is set when the coefficient
+|     of x^k is 1, bit k of two when it is 2.  Coefficient additions on all
+|     64 positions then take a handful of word operations with no carries
+|     or branches.  Used in place of the generic routines when p = 3.
+|
+|     The packed power table is a gf3table owned by the caller and passed
+|     down explicitly, so there is no shared state here.
+|
+|  Functions:
+|
+|     gf3_add
+|     gf3_pack
+|     gf3_unpack
+|     gf3_pack_power_table
+|     gf3_has_power_table
+|     gf3_reduce
+|     gf3_square
+|     gf3_product
+|     gf3_times_x
+|     gf3_x_to_power
+|     gf3_product_residues
+|     gf3_square_residues
+|     gf3_has_multi_irred_factors
+|
+|  LEGAL
+|
+|     Primpoly Version 16.3 - A Program for Computing Primitive Polynomials.
+|     Copyright (C) 1999-2024 by Sean Erik O'Connor.  All Rights Reserved.
+|
+|     This program is free software: you can redistribute it and/or modify
+|     it under the terms of the GNU General Public License as published by
+|     the Free Software Foundation, either version 3 of the License, or
+|     (at your option) any later version.
+|
+|     This program is distributed in the hope that it will be useful,
+|     but WITHOUT ANY WARRANTY; without even the implied warranty of
+|     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+|     GNU General Public License for more details.
+|
+|     You should have received a copy of the GNU General Public License
+|     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+|
+|     The author's address is seanerikoconnor!AT!gmail!DOT!com
+|     with !DOT! replaced by . and the !AT! replaced by @
+|
+==============================================================================*/
+
+/*------------------------------------------------------------------------------
+|                                Include Files                                 |
+------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "Primpoly.h"
+
+
+/*==============================================================================
+|                                   gf3_add                                    |
+================================================================================
+
+DESCRIPTION
+
+     Add two sets of 64 coefficients mod 3 in parallel:  (o1, t1) += (o2, t2).
+     Negation is swapping the planes, so subtraction is adding (t2, o2).
+
+INPUT
+
+     o1, t1 (bigint *)  Bit planes of the 1's and 2's of the first summand.
+     o2, t2 (bigint)    ... and of the second.
+
+OUTPUT
+
+     o1, t1 (bigint *)  Bit planes of the sum.
+
+EXAMPLE
+
+     In one bit position, 1 + 2 has o1 = 1 and t2 = 1, and gives 0:  neither
+     term below is set.
+
+METHOD
+
+     With z = positions where a summand is 0, a sum is 1 for 1 + 0, 0 + 1 and
+     2 + 2, and 2 for 2 + 0, 0 + 2 and 1 + 1.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static void gf3_add( bigint * o1, bigint * t1, bigint o2, bigint t2 )
+{
+    bigint z1 = ~(*o1 | *t1) ;
+    bigint z2 = ~(o2 | t2) ;
+    bigint o  = (*o1 & z2) | (z1 & o2) | (*t1 & t2) ;
+    bigint t  = (*t1 & z2) | (z1 & t2) | (*o1 & o2) ;
+
+    *o1 = o ;
+    *t1 = t ;
+
+} /* ======================= end of function gf3_add ========================= */
+
+
+
+/*==============================================================================
+|                                  gf3_pack                                    |
+================================================================================
+
+DESCRIPTION
+
+     Convert n residues mod 3 to bit planes.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static gf3poly gf3_pack( residue * t, int n )
+{
+    gf3poly a ;
+    int     k ;
+
+    a.one = a.two = 0 ;
+
+    for (k = 0 ;  k < n ;  ++k)
+    {
+        if (t[ k ] == 1)
+            a.one |= (bigint) 1 << k ;
+        else if (t[ k ] == 2)
+            a.two |= (bigint) 1 << k ;
+    }
+
+    return a ;
+
+} /* ======================= end of function gf3_pack ======================== */
+
+
+
+/*==============================================================================
+|                                 gf3_unpack                                   |
+================================================================================
+
+DESCRIPTION
+
+     Convert bit planes back to n residues mod 3.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static void gf3_unpack( gf3poly a, residue * t, int n )
+{
+    int k ;
+
+    for (k = 0 ;  k < n ;  ++k)
+
+        t[ k ] = (residue)( ((a.one >> k) & 1) + 2 * ((a.two >> k) & 1) ) ;
+
+} /* ====================== end of function gf3_unpack ======================= */
+
+
+
+/*==============================================================================
+|                            gf3_pack_power_table                              |
+================================================================================
+
+DESCRIPTION
+
+     Pack a power table mod 3 into bit planes for the routines below.  Called
+     by construct_power_table() whenever p = 3.
+
+INPUT
+
+     power_table (residue **)  x ^ k (mod f(x), 3) for n <= k <= 2n-2.
+     n           (int)         Degree of f(x).
+
+OUTPUT
+
+     gf3         (gf3table *)  The packed rows, marked as being for degree n.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void gf3_pack_power_table( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n )
+{
+    int i ;
+
+    for (i = 0 ;  i <= n - 2 ;  ++i)
+
+        gf3->row[ i ] = gf3_pack( power_table[ i ], n ) ;
+
+    gf3->n = n ;
+
+} /* ================= end of function gf3_pack_power_table ================= */
+
+
+
+/*==============================================================================
+|                             gf3_has_power_table                              |
+================================================================================
+
+DESCRIPTION
+
+     YES if gf3 holds packed rows for degree n >= 2, so the bit-sliced
+     routines can stand in for the generic ones.  gf3 may be null.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int gf3_has_power_table( gf3table * gf3, int n )
+{
+    return (gf3 != NULL && n >= 2 && gf3->n == n) ? YES : NO ;
+
+} /* ================= end of function gf3_has_power_table ================== */
+
+
+
+/*==============================================================================
+|                                 gf3_reduce                                   |
+================================================================================
+
+DESCRIPTION
+
+     Reduce a polynomial of degree <= 2n-2, held in two words per plane,
+     modulo f(x) and 3.
+
+INPUT
+
+     one, two (bigint *)  Bit planes, words 0 and 1 for x^0..x^63 and
+                          x^64..x^127.
+     table    (gf3poly *) Packed power table rows.
+     n        (int)       Degree of f(x).
+
+RETURNS
+
+     The remainder, of degree <= n-1.
+
+METHOD
+                   k                                              k
+     Each nonzero t  x  for n <= k <= 2n-2 is replaced with t  * [x  (mod f(x), 3)]
+                   k                                         k
+     from the packed power table, a single bit-sliced addition, negated
+     when t  = 2.
+           k
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static gf3poly gf3_reduce( bigint * one, bigint * two, gf3poly * table, int n )
+{
+    gf3poly r ;
+    bigint  mask = ((bigint) 1 << n) - 1 ;
+    int     k ;
+
+    r.one = one[ 0 ] & mask ;
+    r.two = two[ 0 ] & mask ;
+
+    for (k = n ;  k <= 2 * n - 2 ;  ++k)
+    {
+        if ((one[ k >> 6 ] >> (k & 63)) & 1)
+            gf3_add( &r.one, &r.two, table[ k - n ].one, table[ k - n ].two ) ;
+        else if ((two[ k >> 6 ] >> (k & 63)) & 1)
+            gf3_add( &r.one, &r.two, table[ k - n ].two, table[ k - n ].one ) ;
+    }
+
+    return r ;
+
+} /* ====================== end of function gf3_reduce ======================= */
+
+
+
+/*==============================================================================
+|                                 gf3_product                                  |
+================================================================================
+
+DESCRIPTION
+
+     s(x) t(x) (mod f(x), 3) on bit planes.
+
+INPUT
+
+     a, b    (gf3poly)   Polynomials of degree <= n-1.
+     table   (gf3poly *) Packed power table rows.
+     n       (int)       Degree of f(x).
+
+RETURNS
+
+     The product, reduced.
+
+METHOD
+
+     Shift-and-add:  for each nonzero coefficient b  add a(x) x^k, negated if
+                                                  k
+     b  = 2, into a 128-bit product.  There are no carries between
+      k
+     coefficients so each step is two word shifts and two gf3_add's.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static gf3poly gf3_product( gf3poly a, gf3poly b, gf3poly * table, int n )
+{
+    bigint one[ 2 ] = { 0, 0 },
+           two[ 2 ] = { 0, 0 },
+           lo_one, lo_two, hi_one, hi_two ;
+    int    k ;
+
+    for (k = 0 ;  k <= n - 1 ;  ++k)
+    {
+        if (!(((b.one | b.two) >> k) & 1))
+            continue ;
+
+        lo_one = a.one << k ;
+        lo_two = a.two << k ;
+        hi_one = k ? a.one >> (64 - k) : 0 ;
+        hi_two = k ? a.two >> (64 - k) : 0 ;
+
+        if ((b.one >> k) & 1)
+        {
+            gf3_add( &one[ 0 ], &two[ 0 ], lo_one, lo_two ) ;
+            gf3_add( &one[ 1 ], &two[ 1 ], hi_one, hi_two ) ;
+        }
+        else
+        {
+            gf3_add( &one[ 0 ], &two[ 0 ], lo_two, lo_one ) ;
+            gf3_add( &one[ 1 ], &two[ 1 ], hi_two, hi_one ) ;
+        }
+    }
+
+    return gf3_reduce( one, two, table, n ) ;
+
+} /* ===================== end of function gf3_product ====================== */
+
+
+
+/*==============================================================================
+|                                 gf3_square                                   |
+================================================================================
+
+DESCRIPTION
+
+     a(x) ^ 2 (mod f(x), 3) on bit planes.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static gf3poly gf3_square( gf3poly a, gf3poly * table, int n )
+{
+    return gf3_product( a, a, table, n ) ;
+
+} /* ====================== end of function gf3_square ======================= */
+
+
+
+/*==============================================================================
+|                                 gf3_times_x                                  |
+================================================================================
+
+DESCRIPTION
+
+     x a(x) (mod f(x), 3) on bit planes.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static gf3poly gf3_times_x( gf3poly a, gf3poly * table, int n )
+{
+    bigint top = (bigint) 1 << n ;
+
+    a.one <<= 1 ;
+    a.two <<= 1 ;
+
+    if (a.one & top)
+    {
+        a.one &= ~top ;
+        gf3_add( &a.one, &a.two, table[ 0 ].one, table[ 0 ].two ) ;
+    }
+    else if (a.two & top)
+    {
+        a.two &= ~top ;
+        gf3_add( &a.one, &a.two, table[ 0 ].two, table[ 0 ].one ) ;
+    }
+
+    return a ;
+
+} /* ====================== end of function gf3_times_x ====================== */
+
+
+
+/*==============================================================================
+|                               gf3_x_to_power                                 |
+================================================================================
+
+DESCRIPTION
+                  m
+     Compute g = x  (mod f(x), 3) on bit planes, for x_to_power().
+
+INPUT
+
+     m      (bigint)       1 <= m.
+     gf3    (gf3table *)   Packed power table of f(x).
+     n      (int)          Degree of f(x).
+
+OUTPUT
+
+     g      (residue *)    The result, of degree <= n-1.
+
+METHOD
+
+     Left to right binary exponentiation, as in x_to_power().
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void gf3_x_to_power( bigint m, residue * g, gf3table * gf3, int n )
+{
+    gf3poly a ;
+    int     bit = NUMBITS - 1 ;
+
+    a.one = (bigint) 1 << 1 ;   /*  a(x) = x */
+    a.two = 0 ;
+
+    while (!((m >> bit) & 1))
+        --bit ;
+
+    while (--bit >= 0)
+    {
+        a = gf3_square( a, gf3->row, n ) ;
+
+        if ((m >> bit) & 1)
+            a = gf3_times_x( a, gf3->row, n ) ;
+    }
+
+    gf3_unpack( a, g, n ) ;
+
+} /* ==================== end of function gf3_x_to_power ==================== */
+
+
+
+/*==============================================================================
+|                            gf3_product_residues                              |
+================================================================================
+
+DESCRIPTION
+
+     s(x) = s(x) t(x) (mod f(x), 3) on residues, for product().
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void gf3_product_residues( residue * s, residue * t, gf3table * gf3, int n )
+{
+    gf3_unpack( gf3_product( gf3_pack( s, n ), gf3_pack( t, n ), gf3->row, n ), s, n ) ;
+
+} /* ================= end of function gf3_product_residues ================= */
+
+
+
+/*==============================================================================
+|                             gf3_square_residues                              |
+================================================================================
+
+DESCRIPTION
+
+     t(x) = t(x) ^ 2 (mod f(x), 3) on residues, for square().
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void gf3_square_residues( residue * t, gf3table * gf3, int n )
+{
+    gf3_unpack( gf3_square( gf3_pack( t, n ), gf3->row, n ), t, n ) ;
+
+} /* ================== end of function gf3_square_residues ================== */
+
+
+
+/*==============================================================================
+|                         gf3_has_multi_irred_factors                          |
+================================================================================
+
+DESCRIPTION
+
+     has_multi_irred_factors() for p = 3:  YES if the nullity of Q - I is 2
+     or more, so f(x) has two or more distinct irreducible factors.
+
+INPUT
+
+     gf3    (gf3table *)  Packed power table of f(x).
+     n      (int)         Degree of f(x).
+
+RETURNS
+
+     1 if f(x) has two or more distinct irreducible factors, 0 otherwise.
+
+METHOD
+                                     3k
+     Row k of Q - I is x^3k = x^3(k-1) x^3 (mod f(x), 3) less x^k, one
+     bit-sliced product per row.  The rank comes from Gaussian elimination on
+     the rows, where eliminating a column from a row is a single gf3_add
+     on all n coefficients.  The nullity is n less the rank.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int gf3_has_multi_irred_factors( gf3table * gf3, int n )
+{
+    gf3poly Q[ MAXDEGPOLY ],    /*  Rows of Q - I.             */
+            xp,                 /*  x^3 (mod f(x), 3)          */
+            row,
+            swap ;
+    bigint  bit ;
+    int     k, i, col, rank = 0 ;
+
+
+    /*  Rows x^3k (mod f(x), 3), starting from 1. */
+    xp.one = (bigint) 1 << 1 ;
+    xp.two = 0 ;
+    xp = gf3_product( gf3_product( xp, xp, gf3->row, n ), xp, gf3->row, n ) ;
+
+    row.one = 1 ;
+    row.two = 0 ;
+
+    for (k = 0 ;  k <= n - 1 ;  ++k)
+    {
+        if (k > 0)
+            row = gf3_product( row, xp, gf3->row, n ) ;
+
+        Q[ k ] = row ;
+
+        /*  Subtract 1 from the diagonal by adding 2. */
+        gf3_add( &Q[ k ].one, &Q[ k ].two, 0, (bigint) 1 << k ) ;
+    }
+
+
+    /*  Row reduce. */
+    for (col = 0 ;  col <= n - 1 && rank < n ;  ++col)
+    {
+        bit = (bigint) 1 << col ;
+
+        for (i = rank ;  i <= n - 1 ;  ++i)
+            if ((Q[ i ].one | Q[ i ].two) & bit)
+                break ;
+
+        if (i > n - 1)
+            continue ;
+
+        swap = Q[ i ] ;  Q[ i ] = Q[ rank ] ;  Q[ rank ] = swap ;
+
+        /*  Scale the pivot to 1. */
+        if (Q[ rank ].two & bit)
+        {
+            swap.one = Q[ rank ].two ;
+            Q[ rank ].two = Q[ rank ].one ;
+            Q[ rank ].one = swap.one ;
+        }
+
+        for (i = rank + 1 ;  i <= n - 1 ;  ++i)
+        {
+            if (Q[ i ].one & bit)       /*  row - pivot row */
+                gf3_add( &Q[ i ].one, &Q[ i ].two, Q[ rank ].two, Q[ rank ].one ) ;
+            else if (Q[ i ].two & bit)  /*  row + pivot row */
+                gf3_add( &Q[ i ].one, &Q[ i ].two, Q[ rank ].one, Q[ rank ].two ) ;
+        }
+
+        ++rank ;
+    }
+
+    return (n - rank >= 2) ? 1 : 0 ;
+
+} /* ============== end of function gf3_has_multi_irred_factors ============== */
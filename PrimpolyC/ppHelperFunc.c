@@ -12,10 +12,13 @@
 |
 |     initial_trial_poly
 |     next_trial_poly
+|     num_trial_polys
+|     carry_from
 |     const_coeff_test
 |     const_coeff_is_primitive_root
 |     skip_test
 |     has_multi_irred_factors
+|     passes_prefilter
 |     generate_Q_matrix
 |     find_nullity
 |
@@ -63,19 +66,24 @@ DESCRIPTION
 
 INPUT
                    
-     f (int *)                Monic polynomial f(x). 
+     f (residue *)            Monic polynomial f(x). 
      n      (int, n >= 1)     Degree of f(x).
+     c (poly_constraints *)   Restrictions on the coefficients.
 
 RETURNS
                                              n
-     f (int *)                Sets f( x ) = x  - 1
-
+     f (residue *)            Sets f( x ) = x  - 1 with no restrictions.
+                              Otherwise fixed coefficients get their values,
+                              the rest their least values, less one for the
+                              lowest of them.
   EXAMPLE 
                              4
      Let n = 4.  Set f(x) = x  - 1.
 
 METHOD
 
+     Either way, next_trial_poly() then gives the first polynomial.
+
 BUGS
 
     None.
@@ -84,7 +92,7 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-void initial_trial_poly( int * f, int n )
+void initial_trial_poly( residue * f, int n, poly_constraints * c )
 {
 
 /*------------------------------------------------------------------------------
@@ -97,11 +105,29 @@ int i ;
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
-f[ 0 ] = -1 ;
+if (!c->active)
+{
+    f[ 0 ] = (residue) -1 ;  /*  Unsigned residues wrap around to 0 too. */
+
+    for (i = 1 ;  i <= n-1 ;  ++i)
+
+        f[ i ] = 0 ;
+
+    f[ n ] = 1 ;
+
+    return ;
+}
+
+for (i = 0 ;  i <= n-1 ;  ++i)
 
-for (i = 1 ;  i <= n-1 ;  ++i)
+    f[ i ] = (residue)(c->coeff[ i ] >= 0 ? c->coeff[ i ] : 
+                       c->coeff[ i ] == NONZERO_COEFF ? 1 : 0) ;
 
-    f[ i ] = 0 ;
+for (i = 0 ;  i <= n-1 && c->coeff[ i ] >= 0 ;  ++i)
+    ;
+
+if (i <= n-1)
+    --f[ i ] ;
 
 f[ n ] = 1 ;
 
@@ -109,6 +135,37 @@ f[ n ] = 1 ;
 
 
 
+/*==============================================================================
+|                                 carry_from                                   |
+================================================================================
+
+DESCRIPTION
+
+     Add 1 to the digit of f(x) at position i or, if that one is fixed, the
+     next one up which isn't, propagating carries through the unfixed digits
+     only.  Past the top digit, all of them wrap around to their least values.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+static void carry_from( residue * f, int i, int n, int p, poly_constraints * c )
+{
+    for ( ;  i <= n - 1 ;  ++i)
+    {
+        if (c->coeff[ i ] >= 0)
+            continue ;
+
+        if (++f[ i ] < p)
+            return ;
+
+        f[ i ] = (c->coeff[ i ] == NONZERO_COEFF) ;
+    }
+
+} /* ==================== end of function carry_from ======================== */
+
+
+
 /*==============================================================================
 |                                next_trial_poly                               |
 ================================================================================
@@ -119,13 +176,14 @@ DESCRIPTION
 
 INPUT
                    
-    f (int *)           Monic polynomial f(x). 
+    f (residue *)       Monic polynomial f(x). 
     n (int, n >= 1)     Degree of monic polynomial f(x).
     p (int, p >= 2)     Modulo p coefficient arithmetic.
+    c (poly_constraints *)  Restrictions on the coefficients.
 
 RETURNS
 
-     f (int *)                Overwrites f(x) with the next polynomial 
+     f (residue *)            Overwrites f(x) with the next polynomial 
                               after it in the sequence (explained below).
 EXAMPLE 
                                            3
@@ -136,6 +194,8 @@ EXAMPLE
                      3    2
      after f(x) is  x  + x .
 
+     With the constant fixed to 4, the next one is 1 1 0 4 instead.
+
 METHOD
 
      Think of the polynomial coefficients as the digits of a number written
@@ -146,6 +206,12 @@ METHOD
      Propagate carries in digits 1 through n-2 when any digit exceeds p.  No
      carries take place in the n-1 st digit because our polynomial is monic.
 
+     With restrictions, fixed digits are skipped over and nonzero ones count
+     from 1 to p-1, so only conforming polynomials come out.  If there are
+     too many nonzero terms, the lowest nonzero free digit must become 0
+     before the weight can drop, so we carry out of it directly, skipping
+     every polynomial in between.
+
 BUGS
 
     None.
@@ -155,7 +221,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    next_trial_poly( int * f, int n, int p )
+    next_trial_poly( residue * f, int n, int p, poly_constraints * c )
 {
 
 /*------------------------------------------------------------------------------
@@ -163,12 +229,44 @@ void
 ------------------------------------------------------------------------------*/
 
 int
-    digit_num ;   /*  Loop counter and digit number. */
+    digit_num,    /*  Loop counter and digit number. */
+    weight ;      /*  Number of nonzero terms.       */
 
 /*------------------------------------------------------------------------------
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
+if (c->active)
+{
+    carry_from( f, 0, n, p, c ) ;
+
+    while (c->max_weight > 0)
+    {
+        for (weight = 1, digit_num = 0 ;  digit_num <= n - 1 ;  ++digit_num)
+            weight += (f[ digit_num ] != 0) ;
+
+        if (weight <= c->max_weight)
+            break ;
+
+        /*  Reset every unfixed digit up to the lowest nonzero free one. */
+        for (digit_num = 0 ;  digit_num <= n - 1 ;  ++digit_num)
+        {
+            if (c->coeff[ digit_num ] == NONZERO_COEFF)
+                f[ digit_num ] = 1 ;
+
+            else if (c->coeff[ digit_num ] == FREE_COEFF && f[ digit_num ] != 0)
+            {
+                f[ digit_num ] = 0 ;
+                break ;
+            }
+        }
+
+        carry_from( f, digit_num + 1, n, p, c ) ;
+    }
+
+    return ;
+}
+
 ++f[ 0 ] ;     /* Add 1, i.e. increment the coefficient of the x term. */
 
 /*
@@ -188,6 +286,94 @@ for (digit_num = 0 ;  digit_num <= n - 2 ;  ++digit_num)
 } /* ================= end of function next_trial_poly ====================== */
 
 
+
+/*==============================================================================
+|                               num_trial_polys                                |
+================================================================================
+
+DESCRIPTION
+
+     The number of polynomials next_trial_poly() runs through.
+
+INPUT
+
+    n (int, n >= 1)        Degree.
+    p (int, p >= 2)        Modulus.
+    c (poly_constraints *) Restrictions on the coefficients.
+
+RETURNS
+                 n
+     (bigint)   p  with no restrictions, else the number which conform.
+
+EXAMPLE
+                                                                2
+     Let n = 4, p = 3, the constant fixed to 2 and weight at most 3.  Of 3
+     choices for the other coefficients, 1 has no nonzero ones, and 2 + 2 + 2
+     have one, so there are 7 polynomials.
+
+METHOD
+
+     Count by weight, one coefficient at a time:  a free coefficient keeps
+     the weight in 1 way and adds one in p-1 ways.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+bigint num_trial_polys( int n, int p, poly_constraints * c )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+bigint
+    count[ MAXDEGPOLY + 2 ],  /*  count[ w ] polynomials have weight w so far. */
+    total = 0 ;
+
+int
+    i, w ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (!c->active)
+    return power( p, n ) ;
+
+for (w = 0 ;  w <= n + 1 ;  ++w)
+    count[ w ] = 0 ;
+
+count[ 1 ] = 1 ;  /*  The x^n term. */
+
+for (i = 0 ;  i <= n - 1 ;  ++i)
+
+    for (w = i + 2 ;  w >= 1 ;  --w)
+    {
+        if (c->coeff[ i ] == FREE_COEFF)
+            count[ w ] = count[ w ] + count[ w - 1 ] * (p - 1) ;
+
+        else if (c->coeff[ i ] == NONZERO_COEFF)
+            count[ w ] = count[ w - 1 ] * (p - 1) ;
+
+        else if (c->coeff[ i ] != 0)
+            count[ w ] = count[ w - 1 ] ;
+    }
+
+for (w = 1 ;  w <= n + 1 ;  ++w)
+
+    if (c->max_weight == 0 || w <= c->max_weight)
+        total += count[ w ] ;
+
+return total ;
+
+} /* =================== end of function num_trial_polys ==================== */
+
+
 /*==============================================================================
 |                               const_coeff_test                               |
 ================================================================================
@@ -201,7 +387,7 @@ DESCRIPTION
 
 INPUT
 
-    f (int *)  nth degree monic mod p polynomial f(x). 
+    f (residue *) nth degree monic mod p polynomial f(x). 
     n (int)    Its degree.
     p (int)    Modulus for coefficient arithmetic.
     a (int)
@@ -231,7 +417,7 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-int const_coeff_test( int * f, int n, int p, int a )
+int const_coeff_test( residue * f, int n, int p, int a )
 {
 
 /*------------------------------------------------------------------------------
@@ -267,7 +453,7 @@ DESCRIPTION
 
 INPUT
 
-    f (int *)  nth degree monic mod p polynomial f(x). 
+    f (residue *) nth degree monic mod p polynomial f(x). 
     n (int)    Its degree.
     p (int)    Modulus for coefficient arithmetic.
 
@@ -296,7 +482,7 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-int const_coeff_is_primitive_root( int * f, int n, int p )
+int const_coeff_is_primitive_root( residue * f, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -390,7 +576,8 @@ DESCRIPTION
 
 INPUT
 
-    power_table (int **)   x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    gf3 (gf3table *) Its bit planes for p = 3, or NULL.
     n (int, n >= 1)        Degree of monic polynomial f(x).
     p (int, p >= 2)        Modulo p coefficient arithmetic.
 
@@ -436,19 +623,23 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-int has_multi_irred_factors( int power_table[][ MAXDEGPOLY ], int n, int p )
+int has_multi_irred_factors( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
 {
-    int ** Q ;
+    residue ** Q ;
     int row ;
 	int nullity = 0 ;
 
 
+    /* Modulo 3, work on bit planes instead. */
+    if (p == 3 && gf3_has_power_table( gf3, n ))
+        return gf3_has_multi_irred_factors( gf3, n ) ;
+
     /* Allocate space for the Q matrix. */
-    Q = (int **) calloc( n, sizeof( int * ) ) ;
+    Q = (residue **) calloc( n, sizeof( residue * ) ) ;
 
     for (row = 0 ;  row < n ;  ++row)
     {
-        Q[ row ] = (int *)calloc( n, sizeof( int ) ) ;
+        Q[ row ] = (residue *)calloc( n, sizeof( residue ) ) ;
     }
 
 
@@ -482,6 +673,94 @@ int has_multi_irred_factors( int power_table[][ MAXDEGPOLY ], int n, int p )
 
 
 
+/*==============================================================================
+|                              passes_prefilter                                |
+================================================================================
+
+DESCRIPTION
+
+     Run the first three primitivity tests on f(x), the ones which don't need
+     the factors of r, and count how many candidates pass each one.
+
+INPUT
+
+    f           (residue *) nth degree monic mod p polynomial f(x).
+    power_table (residue **) x ^ n, ..., x ^ 2n-2 (mod f(x), p).
+    gf3 (gf3table *) Its bit planes for p = 3, or NULL.
+    n           (int)    Its degree.
+    p           (int)    Modulus for coefficient arithmetic.
+
+OUTPUT
+
+    num_const_coeff_prim_root  (int *)  Incremented if f(x) passes the first,
+    num_free_of_linear_factors (int *)  second,
+    num_irred_to_power         (int *)  and third tests.
+
+RETURNS
+
+    YES if f(x) has a constant coefficient which is a primitive root, has
+    no linear factors, and is irreducible or an irreducible to a power.
+    NO otherwise.
+
+METHOD
+
+    Since these tests don't depend on r's prime factors, main() can run
+    them on a stream of candidates while r is still being factored.
+
+BUGS
+
+    None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int passes_prefilter( residue * f, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p,
+                      int * num_const_coeff_prim_root,
+                      int * num_free_of_linear_factors,
+                      int * num_irred_to_power )
+{
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+/* Constant coefficient of f(x) * (-1)^n must be a primitive root of p. */
+if (!const_coeff_is_primitive_root( f, n, p ))
+    return NO ;
+
+++*num_const_coeff_prim_root ;
+
+#ifdef DEBUG_PP_PRIMPOLY
+printf( "Coefficient of polynomial is primitive root.\n" ) ;
+#endif
+
+/* f(x) can't have any linear factors. */
+if (linear_factor( f, n, p ))
+    return NO ;
+
+++*num_free_of_linear_factors ;
+
+#ifdef DEBUG_PP_PRIMPOLY
+printf( "Free of linear factors.\n" ) ;
+#endif
+
+/* f(x) can't have two or more distinct irreducible factors. */
+if (has_multi_irred_factors( power_table, gf3, n, p ))
+    return NO ;
+
+++*num_irred_to_power ;
+
+#ifdef DEBUG_PP_PRIMPOLY
+printf( "Has one unique irreducible factor.\n" ) ;
+#endif
+
+return YES ;
+
+} /* =================== end of function passes_prefilter =================== */
+
+
+
 /*==============================================================================
 |                              generate_Q_matrix                               |
 ================================================================================
@@ -499,11 +778,11 @@ DESCRIPTION
 
 INPUT
 
-    Q (int **)             Memory is allocated for this matrix already and 
+    Q (residue **)         Memory is allocated for this matrix already and 
 	                       all entries are 0.
 
                             k
-    power_table (int **)   x (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x (mod f(x), p) for n <= k <= 2n-2, f monic.
   
     n (int, n >= 1)        Degree of monic polynomial f(x).
 
@@ -547,15 +826,15 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    generate_Q_matrix( int ** Q, int power_table[][ MAXDEGPOLY ], int n, int p )
+    generate_Q_matrix( residue ** Q, residue power_table[][ MAXDEGPOLY ], int n, int p )
 {
 
 /*------------------------------------------------------------------------------
 |                               Local Variables                                |
 ------------------------------------------------------------------------------*/
 
-int xp[ MAXDEGPOLY ] ; /* x^p (mod f(x),p)         */
-int q [ MAXDEGPOLY ] ; /* Current row of Q matrix. */
+residue xp[ MAXDEGPOLY ] ; /* x^p (mod f(x),p)         */
+residue q [ MAXDEGPOLY ] ; /* Current row of Q matrix. */
 
 int row = 0 ;
 
@@ -565,7 +844,7 @@ int row = 0 ;
 ------------------------------------------------------------------------------*/
 
 /* Check for invalid inputs. */
-if (n < 2 || p < 2 || Q == (int **)0)
+if (n < 2 || p < 2 || Q == (residue **)0)
 {
     return ;
 }
@@ -580,10 +859,10 @@ Q[ 0 ][ 0 ] = 1 ;
    Find x  (mod f(x),p) save the value into q(x) and
    set row 1 of Q to this value.
 */
-x_to_power( (bigint) p, xp, power_table, n, p ) ;
+x_to_power( (bigint) p, xp, power_table, NULL, n, p ) ;
 
-memcpy( q,     xp, n * sizeof( int ) ) ;
-memcpy( Q[ 1 ], q, n * sizeof( int ) ) ;
+memcpy( q,     xp, n * sizeof( residue ) ) ;
+memcpy( Q[ 1 ], q, n * sizeof( residue ) ) ;
 
 
 /*               pk
@@ -593,8 +872,8 @@ memcpy( Q[ 1 ], q, n * sizeof( int ) ) ;
 */
 for (row = 2 ;  row <= n-1 ;  ++row)
 {
-    product( q, xp, power_table, n, p ) ;
-    memcpy( Q[ row ], q, n * sizeof( int ) ) ;
+    product( q, xp, power_table, NULL, n, p ) ;
+    memcpy( Q[ row ], q, n * sizeof( residue ) ) ;
 }
 
 
@@ -621,7 +900,7 @@ DESCRIPTION
 
 INPUT
 
-    Q (int **)          Matrix of integers mod p. 
+    Q (residue **)      Matrix of integers mod p. 
     n (int, n >= 1)     Degree of monic polynomial f(x).
     p (int, p >= 2)     Modulo p coefficient arithmetic.
 
@@ -721,7 +1000,7 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-int find_nullity( int ** Q, int n, int p )
+int find_nullity( residue ** Q, int n, int p )
 {
 
 int colFlag[ MAXDEGPOLY ] ; /* Is -1 if the column has no pivotal element. */
@@ -813,8 +1092,8 @@ int test
 n = 4 ; p = 5 ;
 f[0] = 2 ; f[1] = 3 ; f[2] = 3 ; f[3] = 3 ; f[4] = 1 ;
 
-construct_power_table( power_table, f, n, p ) ;
-if (has_multi_irred_factors( power_table, n, p ) == 1)
+construct_power_table( power_table, NULL, f, n, p ) ;
+if (has_multi_irred_factors( power_table, NULL, n, p ) == 1)
     printf( "Pass\n" ) ;
 else
     printf( "Fail\n" ) ;
@@ -11,6 +11,8 @@
 |  Functions:
 |
 |      parse_command_line
+|      parse_constraint
+|      parse_poly
 |      write_poly
 |
 |  LEGAL
@@ -76,6 +78,11 @@ EXAMPLE CALLING SEQUENCE
    pp -t 2 4 x^3+x^2+1     Checks a polynomial for primitivity.  No blanks, please!
    pp -a 2 4               Lists all primitive polynomials of degree 4 modulo 2.
    pp -c 2 4               Does a time-consuming double check on primitivity.
+   pp -C 2 4               Finds the Conway polynomial of degree 4 modulo 2.
+   pp -a 2 8 a0=1 w=5      Lists those of degree 8 with at most 5 terms.
+   pp -o 2 5 x^5+x^3+x^2+1 Finds the order of x modulo a polynomial.
+   pp -f 3 4 x^4+2x^3+x+2  Factors a polynomial into irreducibles.
+   pp -i -a 2 4            Lists all irreducible polynomials of degree 4 modulo 2.
 
 METHOD
 
@@ -97,9 +104,14 @@ int parse_command_line( int    argc,
                         int *  printStatistics,
                         int *  printHelp,
                         int *  selfCheck,
+                        int *  conwayPolynomial,
+                        int *  orderOfPolynomial,
+                        int *  factorPolynomial,
+                        int *  irreduciblePolynomial,
                         int *  p,
                         int *  n,
-                        int *  testPolynomial )
+                        int *  testPolynomial,
+                        poly_constraints * constraints )
 {
 
 int    input_arg_index ;
@@ -107,6 +119,9 @@ char * input_arg_string ;
 char * option_ptr ;
 
 int    num_arg ;
+int    i ;
+int    status ;
+int    infeasible = NO ;
 char * arg_string[ _MAX_PATH ] ;
 
 /*  Initialize to defaults. */
@@ -115,9 +130,21 @@ char * arg_string[ _MAX_PATH ] ;
 *printStatistics              = NO ;
 *printHelp                    = NO ;
 *selfCheck                    = NO ;
+*conwayPolynomial             = NO ;
+*orderOfPolynomial            = NO ;
+*factorPolynomial             = NO ;
+*irreduciblePolynomial        = NO ;
 *p                            = 0 ;
 *n                            = 0 ;
-testPolynomial                = (int *) 0 ;
+
+for (i = 0 ;  i <= MAXDEGPOLY ;  ++i)
+    testPolynomial[ i ] = 0 ;
+
+for (i = 0 ;  i < MAXDEGPOLY ;  ++i)
+    constraints->coeff[ i ] = FREE_COEFF ;
+
+constraints->max_weight = 0 ;
+constraints->active     = NO ;
 
 
 /*
@@ -165,25 +192,80 @@ for (input_arg_index = 0, num_arg = 0 ;  input_arg_index < argc ;
 					*selfCheck = YES ;
                 break ;
 
+                /* Find the Conway polynomial. */
+                case 'C':
+                    *conwayPolynomial = YES ;
+                break ;
+
+                /* Find the order of x modulo a given polynomial. */
+                case 'o':
+                    *orderOfPolynomial = YES ;
+                break ;
+
+                /* Factor a given polynomial. */
+                case 'f':
+                    *factorPolynomial = YES ;
+                break ;
+
+                /* Find irreducible instead of primitive polynomials. */
+                case 'i':
+                    *irreduciblePolynomial = YES ;
+                break ;
+
                 default:
                    printf( "Cannot recognize the option %c\n", *option_ptr ) ;
                 break ;
             }
         }
     }
-    else  /* Not an option, but an argument. */
+    else if (num_arg < _MAX_PATH)  /* Not an option, but an argument. */
     {
         arg_string[ num_arg++ ] = input_arg_string ;
     }
 }
 
 
-/* Assume the next two arguments are p and n. */
-if (num_arg == 3)
+/* Assume the next two arguments are p and n, and any others a polynomial
+   (starting with x or a digit) or constraints. */
+if (num_arg >= 3)
 {
     *p = atoi( arg_string[ 1 ] ) ;
     *n = atoi( arg_string[ 2 ] ) ;
 
+    for (i = 3 ;  i < num_arg ;  ++i)
+    {
+        if (arg_string[ i ][ 0 ] == 'x' || 
+            (arg_string[ i ][ 0 ] >= '0' && arg_string[ i ][ 0 ] <= '9'))
+        {
+            if (!parse_poly( arg_string[ i ], *n, *p, testPolynomial ))
+            {
+                printf( "ERROR:  Cannot understand the polynomial %s of degree %d\n\n", 
+                        arg_string[ i ], *n ) ;
+                *printHelp = YES ;
+            }
+        }
+        else if ((status = parse_constraint( arg_string[ i ], *n, *p, constraints )) == INFEASIBLE_CONSTRAINT)
+        {
+            /*  Not this argument's fault alone;  report it once, below. */
+            infeasible = YES ;
+        }
+        else if (status != YES)
+        {
+            if (status == CONFLICTING_CONSTRAINT)
+                printf( "ERROR:  The constraint %s conflicts with an earlier one\n\n", 
+                        arg_string[ i ] ) ;
+            else
+                printf( "ERROR:  Cannot understand the constraint %s\n\n", arg_string[ i ] ) ;
+            *printHelp = YES ;
+        }
+    }
+
+    if (infeasible)
+    {
+        printf( "ERROR:  The constraints leave no polynomials with at most %d nonzero terms\n\n",
+                constraints->max_weight ) ;
+        *printHelp = YES ;
+    }
 }
 else
 {
@@ -196,6 +278,259 @@ return 0 ;
 } /* ================ end of function parse_command_line ==================== */
 
 
+
+/*==============================================================================
+|                               parse_constraint                               |
+================================================================================
+
+DESCRIPTION
+
+     Parse one restriction on the coefficients of the polynomials searched.
+
+INPUT
+
+     s  (char *)   One of
+
+                       ak=v    The coefficient of x^k is v, 0 <= k < n.
+                       ak=nz   The coefficient of x^k is nonzero.
+                       t=v     The trace of a root of f(x) is v, so the
+                               coefficient of x^(n-1) is -v (mod p).
+                       t=nz    The trace is nonzero.
+                       w=m     f(x) has at most m nonzero terms, x^n included.
+
+     n, p  (int)   Degree and modulus.
+
+OUTPUT
+
+     constraints  (poly_constraints *)  Updated.
+
+RETURNS
+
+     YES if understood, NO if malformed or out of range,
+     CONFLICTING_CONSTRAINT if it restricts a term (or the weight) already
+     restricted differently, INFEASIBLE_CONSTRAINT if it is recorded but the
+     constraints so far force more nonzero terms than the weight allows.
+     A repeat is fine, and nz together with a nonzero value keeps the value.
+
+EXAMPLE
+
+     pp -a 2 8 a0=1 w=5 lists the primitive polynomials of degree 8 modulo 2
+     with at most 5 terms.  (Primitive ones always have a nonzero constant.)
+     pp -a 3 4 t=1 a3=1 is rejected, since t=1 makes the coefficient of x^3
+     equal to 2.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int parse_constraint( char * s, int n, int p, poly_constraints * constraints )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    k,                   /*  Degree of the term restricted.      */
+    value,               /*  Its value, or NONZERO_COEFF.        */
+    old,                 /*  Earlier restriction of the term.    */
+    min_weight = 1,      /*  Fewest nonzero terms possible.      */
+    is_trace = NO,       /*  YES for t=.                         */
+    i,
+    used = 0 ;           /*  Characters sscanf() consumed.       */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (n < 1 || n > MAXDEGPOLY || p < 2)
+    return NO ;
+
+if (sscanf( s, "w=%d%n", &value, &used ) == 1 && s[ used ] == '\0')
+{
+    if (value < 1)
+        return NO ;
+
+    if (constraints->max_weight != 0 && constraints->max_weight != value)
+        return CONFLICTING_CONSTRAINT ;
+
+    constraints->max_weight = value ;
+}
+else
+{
+    if (s[ 0 ] == 't' && s[ 1 ] == '=')
+    {
+        k = n - 1 ;
+        s += 2 ;
+        is_trace = YES ;
+    }
+    else if (sscanf( s, "a%d=%n", &k, &used ) == 1 && used > 0)
+        s += used ;
+    else
+        return NO ;
+
+    if (k < 0 || k > n - 1)
+        return NO ;
+
+    if (s[ 0 ] == 'n' && s[ 1 ] == 'z' && s[ 2 ] == '\0')
+        value = NONZERO_COEFF ;
+    else if (sscanf( s, "%d%n", &value, &used ) == 1 && s[ used ] == '\0' &&
+             value >= 0 && value < p)
+    {
+        if (is_trace)
+            value = mod( -value, p ) ;
+    }
+    else
+        return NO ;
+
+    old = constraints->coeff[ k ] ;
+
+    if (old == NONZERO_COEFF && value > 0)
+        ;
+    else if (value == NONZERO_COEFF && old > 0)
+        value = old ;
+    else if (old != FREE_COEFF && old != value)
+        return CONFLICTING_CONSTRAINT ;
+
+    constraints->coeff[ k ] = value ;
+}
+
+constraints->active = YES ;
+
+for (i = 0 ;  i <= n - 1 ;  ++i)
+    min_weight += (constraints->coeff[ i ] > 0 || 
+                   constraints->coeff[ i ] == NONZERO_COEFF) ;
+
+if (constraints->max_weight != 0 && min_weight > constraints->max_weight)
+    return INFEASIBLE_CONSTRAINT ;
+
+return YES ;
+
+} /* ================ end of function parse_constraint ====================== */
+
+
+
+/*==============================================================================
+|                                  parse_poly                                  |
+================================================================================
+
+DESCRIPTION
+
+     Read a polynomial of degree n written as a sum of terms c x^k, without
+     blanks.
+
+INPUT
+
+     s  (char *)   Terms c, x, x^k, c x^k or c*x^k joined by + or -, in any
+                   order.  Coefficients are reduced modulo p.
+
+     n, p  (int)   Degree and modulus.
+
+OUTPUT
+
+     a  (int *)    Coefficients a[ 0 ], ..., a[ n ].
+
+RETURNS
+
+     YES if understood and of degree exactly n, NO otherwise.
+
+EXAMPLE
+
+     For p = 3, n = 4, the string x^4+2x^3-x+2 gives a[] = { 2, 2, 0, 2, 1 }.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int parse_poly( char * s, int n, int p, int * a )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int
+    i,
+    k,                   /*  Degree of the term.                 */
+    c,                   /*  Its coefficient.                    */
+    sign,                /*  -1 after a minus sign.              */
+    has_coeff,           /*  YES if c was written out.           */
+    used = 0 ;           /*  Characters sscanf() consumed.       */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (n < 1 || n > MAXDEGPOLY || p < 2)
+    return NO ;
+
+for (i = 0 ;  i <= n ;  ++i)
+    a[ i ] = 0 ;
+
+while (*s != '\0')
+{
+    sign = 1 ;
+
+    if (*s == '+')
+        ++s ;
+    else if (*s == '-')
+    {
+        sign = -1 ;
+        ++s ;
+    }
+
+    c = 1 ;
+    has_coeff = NO ;
+
+    if (*s >= '0' && *s <= '9')
+    {
+        if (sscanf( s, "%d%n", &c, &used ) != 1)
+            return NO ;
+
+        s += used ;
+        has_coeff = YES ;
+
+        if (*s == '*')
+            ++s ;
+    }
+
+    if (*s == 'x')
+    {
+        ++s ;
+        k = 1 ;
+
+        if (*s == '^')
+        {
+            if (sscanf( s + 1, "%d%n", &k, &used ) != 1 || s[ 1 ] == '-')
+                return NO ;
+
+            s += 1 + used ;
+        }
+    }
+    else if (has_coeff)
+        k = 0 ;
+    else
+        return NO ;
+
+    if (k > n || (*s != '+' && *s != '-' && *s != '\0'))
+        return NO ;
+
+    a[ k ] = mod( a[ k ] + sign * mod( c, p ), p ) ;
+}
+
+return (a[ n ] != 0) ;
+
+} /* =================== end of function parse_poly ========================= */
+
+
 /*==============================================================================
 |                                    write_poly                                |
 ================================================================================
@@ -208,7 +543,7 @@ DESCRIPTION
 
 INPUT
                                                                      n
-     a[]  (int *)  Coefficients of the nth degree polynomial a(x) = a x  + ...
+     a[]  (residue *) Coefficients of the nth degree polynomial a(x) = a x  + ...
                                                                      n
                    + a  x  +  a.    a  is stored at array location a[i], 
                       1        0     i
@@ -247,7 +582,7 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-void write_poly( int * a, int n )
+void write_poly( residue * a, int n )
 {
 
 /*------------------------------------------------------------------------------
@@ -13,6 +13,8 @@
 |     order_m
 |     order_r
 |     maximal_order
+|     order_of_x
+|     order_is_exact
 |
 |  LEGAL
 |
@@ -61,7 +63,8 @@ DESCRIPTION
 
 INPUT
 
-     power_table (int **)     x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+     power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+     gf3 (gf3table *) Its bit planes for p = 3, or NULL.
      n      (int, n >= 1)     Degree of f(x).
      p      (int)             Modulo p coefficient arithmetic.
      r (int)                  See above.
@@ -102,7 +105,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int
-    order_m( int power_table[][ MAXDEGPOLY ], int n, int p, bigint r,
+    order_m( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p, bigint r,
              bigint * primes, int prime_count )
 {
 
@@ -111,7 +114,9 @@ int
 ------------------------------------------------------------------------------*/
 
 int
-    i,                  /*  Loop counter.  */
+    i ;                 /*  Loop counter.  */
+
+residue
     g[ MAXDEGPOLY ] ;   /* g(x) = x ^ m (mod f(x), p) */
 
 bigint
@@ -127,7 +132,7 @@ for (i = 0 ;  i <= prime_count ;  ++i)
     {
         m = r / primes[ i ] ;
 
-        x_to_power( m, g, power_table, n, p ) ;
+        x_to_power( m, g, power_table, gf3, n, p ) ;
 
         #ifdef DEBUG_PP_PRIMPOLY
         printf( "    order m test for prime = %lld, x^ m = x ^ %lld = ", primes[i], m ) ;
@@ -156,7 +161,8 @@ DESCRIPTION
 
 INPUT
 
-     power_table (int **)     x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+     power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+     gf3 (gf3table *) Its bit planes for p = 3, or NULL.
      n      (int, n >= 1)     Degree of f(x).
      p      (int)             Modulo p coefficient arithmetic.
      r (int)                  See above.
@@ -187,21 +193,21 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int
-    order_r( int power_table[][ MAXDEGPOLY ], int n, int p, bigint r, int * a )
+    order_r( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p, bigint r, int * a )
 {
 
 /*------------------------------------------------------------------------------
 |                               Local Variables                                |
 ------------------------------------------------------------------------------*/
 
-int
+residue
     g[ MAXDEGPOLY ] ;   /* g(x) = x ^ m (mod f(x), p) */
 
 /*------------------------------------------------------------------------------
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
-x_to_power( r, g, power_table, n, p ) ;
+x_to_power( r, g, power_table, gf3, n, p ) ;
  
 #ifdef DEBUG_PP_PRIMPOLY
 printf( "    order r test for x^r = x ^ %lld = ", r ) ;
@@ -229,7 +235,7 @@ DESCRIPTION
 
 INPUT
 
-     f (int *)                Monic polynomial f(x).
+     f (residue *)            Monic polynomial f(x).
      n      (int, n >= 1)     Degree of f(x).
      p      (int)             Modulo p coefficient arithmetic.
 
@@ -266,25 +272,26 @@ BUGS
 |                                Function Call                                 |
 ------------------------------------------------------------------------------*/
 
-int maximal_order( int * f, int n, int p )
+int maximal_order( residue * f, int n, int p )
 {
-    int g[ MAXDEGPOLY ] ;   /* g(x) = x ^ m (mod f(x), p) */
+    residue g[ MAXDEGPOLY ] ;   /* g(x) = x ^ m (mod f(x), p) */
     bigint maxOrder ;
     bigint k ;
-    int power_table[ MAXDEGPOLY - 1 ] [ MAXDEGPOLY ] ;    /*  x ^ n , ... , x ^ 2n-2 (mod f(x), p) */
+    residue power_table[ MAXDEGPOLY - 1 ] [ MAXDEGPOLY ] ;    /*  x ^ n , ... , x ^ 2n-2 (mod f(x), p) */
+    gf3table gf3 ;                                          /*  Its bit planes for p = 3. */
 
     /*                         n         2n-2
         Precompute the powers x ,  ..., x     (mod f(x), p)
         for use in all later computations.
     */
-    construct_power_table( power_table, f, n, p ) ;
+    construct_power_table( power_table, &gf3, f, n, p ) ;
 
     /*  Highest possible order for x. */
     maxOrder = power( p, n ) - 1 ;
 
     for (k = 1 ;  k <= maxOrder ;  ++k)
     {
-        x_to_power( k, g, power_table, n, p ) ;
+        x_to_power( k, g, power_table, &gf3, n, p ) ;
 
         if (is_integer( g, n-1 ) &&
             g[0] == 1 &&
@@ -298,3 +305,279 @@ int maximal_order( int * f, int n, int p )
     return 1 ;
 
 } /* ================= end of function maximal_order ======================== */
+
+
+
+/*==============================================================================
+|                                  order_of_x                                  |
+================================================================================
+
+DESCRIPTION
+                                   k + e    k
+    The least e >= 1 for which x      = x  (mod f(x), p) for all large
+                                                                       k
+    enough k, together with the pre-period, the least k with that.  If
+    f(0) != 0, the pre-period is 0 and e is the order of x in the ring of
+    polynomials modulo f(x) and p.
+
+INPUT
+
+     f (residue *)            Monic polynomial f(x), not necessarily
+                              irreducible.
+     n      (int, n >= 1)     Degree of f(x).
+     p      (int)             Modulo p coefficient arithmetic.
+
+OUTPUT
+
+     pre_period  (int *)          Power of x dividing f(x).
+     factors     (poly_factor *)  The products of the irreducible factors of
+                                  f(x) of each multiplicity and degree, with
+                                  the order of x modulo each one.  Room for
+                                  MAXDEGPOLY of them.
+     num_factors (int *)          How many.
+
+RETURNS
+
+     The order e.
+
+EXAMPLE
+                       5    3    2                   2
+     Let p = 2, f(x) = x  + x  + x  + 1 = (x + 1)^3 (x  + x + 1).  The
+                                                      2
+     order of x modulo x + 1 is 1 and modulo x  + x + 1 is 3.  The
+     multiplicity 3 gives a factor of 4, the least power of 2 at least
+     3, so the order is lcm( 1, 3 ) 4 = 12.
+
+METHOD
+                             h
+     Divide out f(x) = x  g(x) with g(0) != 0;  h is the pre-period.
+                                                e1      ek
+     Factor g(x) into square free parts, g = a1   ... ak  , and split each
+     ai(x) into the products of its irreducible factors of each degree d.
+                                                                    d
+     The order of x modulo such a product D(x) divides all of the p  - 1,
+     so we start from that and divide out each prime q of the factorization
+                           e/q
+     for as long as that  x    = 1 (mod D(x), p).  The factorizations are
+     kept for each d.  The order of x modulo g(x) is the lcm of these, times
+       t                     t
+     p  for the least t with p  >= max ei [Lidl and Niederreiter,
+     Theorems 3.8 and 3.9].
+
+BUGS
+
+    None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+bigint order_of_x( residue * f, int n, int p, int * pre_period, 
+                   poly_factor * factors, int * num_factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    g[ MAXDEGPOLY + 1 ],             /*  f(x) with the powers of x removed. */
+    h[ MAXDEGPOLY ],                 /*  x ^ m (mod D(x), p)                */
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+poly_factor
+    square_free[ MAXDEGPOLY ] ;      /*  Square free parts of g(x).         */
+
+factorization
+    pn1[ MAXDEGPOLY + 1 ] ;          /*  p ^ d - 1 for each degree d.       */
+
+int
+    have_pn1[ MAXDEGPOLY + 1 ],      /*  YES once pn1[ d ] is known.        */
+    num_square_free,
+    max_multiplicity = 1,
+    shift = 0,
+    i, j, d, m, num = 0 ;
+
+bigint
+    order = 1,                       /*  lcm of the orders so far.          */
+    e,                               /*  Order modulo one factor.           */
+    q,                               /*  A prime dividing p ^ d - 1.        */
+    u, v, w,
+    pt ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+while (shift < n && f[ shift ] == 0)
+    ++shift ;
+
+for (j = shift ;  j <= n ;  ++j)
+    g[ j - shift ] = f[ j ] ;
+
+*pre_period  = shift ;
+*num_factors = 0 ;
+
+if (n == shift)
+    return 1 ;
+
+for (d = 0 ;  d <= MAXDEGPOLY ;  ++d)
+    have_pn1[ d ] = NO ;
+
+
+/*  Square free and then distinct degree factorization. */
+num_square_free = square_free_factor( g, n - shift, p, square_free ) ;
+
+for (i = 0 ;  i < num_square_free ;  ++i)
+    num += distinct_degree_factor( &square_free[ i ], p, &factors[ num ] ) ;
+
+
+for (i = 0 ;  i < num ;  ++i)
+{
+    d = factors[ i ].factor_degree ;
+    m = factors[ i ].degree ;
+
+    if (!have_pn1[ d ])
+    {
+        factor_p_to_n_minus_1( p, d, &pn1[ d ] ) ;
+        have_pn1[ d ] = YES ;
+    }
+
+    e = power( p, d ) - 1 ;
+
+    if (m >= 2)
+        construct_power_table( power_table, &gf3, factors[ i ].poly, m, p ) ;
+
+    /*  Divide each prime out of e while x ^ (e/q) is still 1. */
+    for (j = 0 ;  j < pn1[ d ].num_primes ;  ++j)
+    {
+        q = pn1[ d ].primes[ j ] ;
+
+        while (e % q == 0)
+        {
+            if (m == 1)
+            {
+                /*  x = -a0 (mod x + a0, p). */
+                if (power_mod( (p - factors[ i ].poly[ 0 ]) % p, (int)(e / q), p ) != 1)
+                    break ;
+            }
+            else
+            {
+                x_to_power( e / q, h, power_table, &gf3, m, p ) ;
+
+                if (!is_integer( h, m - 1 ) || h[ 0 ] != 1)
+                    break ;
+            }
+
+            e /= q ;
+        }
+    }
+
+    factors[ i ].order = e ;
+
+    /*  order = lcm( order, e ) */
+    for (u = order, v = e ;  v != 0 ;  w = u % v, u = v, v = w)
+        ;
+
+    order = order / u * e ;
+
+    if (factors[ i ].multiplicity > max_multiplicity)
+        max_multiplicity = factors[ i ].multiplicity ;
+}
+
+for (pt = 1 ;  pt < (bigint) max_multiplicity ;  pt *= p)
+    ;
+
+*num_factors = num ;
+
+return order * pt ;
+
+} /* ==================== end of function order_of_x ======================== */
+
+
+
+/*==============================================================================
+|                                order_is_exact                                |
+================================================================================
+
+DESCRIPTION
+                                         h + e    h               h + e/q    h
+     Check directly modulo f(x) that x      = x  (mod f(x), p) but x        != x
+     for every prime q dividing e, without factoring f(x).
+
+INPUT
+
+     f (residue *)            Monic polynomial f(x).
+     n      (int, n >= 2)     Degree of f(x).
+     p      (int)             Modulo p coefficient arithmetic.
+     e      (bigint)          Order of x claimed by order_of_x().
+     h      (int)             Pre-period claimed.
+
+RETURNS
+
+     YES    if e is the order.
+     NO     if it isn't.
+
+METHOD
+
+     The powers of x past the pre-period repeat with period e exactly when
+     e is a multiple of the period but no e/q is.
+
+BUGS
+
+    None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int order_is_exact( residue * f, int n, int p, bigint e, int h )
+{
+    residue g [ MAXDEGPOLY ] ;   /* x ^ (h + m) (mod f(x), p) */
+    residue xh[ MAXDEGPOLY ] ;   /* x ^ h (mod f(x), p) */
+    residue power_table[ MAXDEGPOLY - 1 ] [ MAXDEGPOLY ] ;
+    gf3table gf3 ;
+    bigint  primes[ MAXNUMPRIMEFACTORS ] ;
+    int     count [ MAXNUMPRIMEFACTORS ] ;
+    int     num_primes = 0 ;
+    int     i, j ;
+
+    construct_power_table( power_table, &gf3, f, n, p ) ;
+
+    if (h == 0)
+    {
+        for (j = 0 ;  j <= n - 1 ;  ++j)
+            xh[ j ] = 0 ;
+
+        xh[ 0 ] = 1 ;
+    }
+    else
+        x_to_power( (bigint) h, xh, power_table, &gf3, n, p ) ;
+
+    x_to_power( h + e, g, power_table, &gf3, n, p ) ;
+
+    for (j = 0 ;  j <= n - 1 ;  ++j)
+        if (g[ j ] != xh[ j ])
+            return NO ;
+
+    if (e > 1)
+        num_primes = factor( e, primes, count ) + 1 ;
+
+    for (i = 0 ;  i < num_primes ;  ++i)
+    {
+        x_to_power( h + e / primes[ i ], g, power_table, &gf3, n, p ) ;
+
+        for (j = 0 ;  j <= n - 1 ;  ++j)
+            if (g[ j ] != xh[ j ])
+                break ;
+
+        if (j > n - 1)
+            return NO ;
+    }
+
+    return YES ;
+
+} /* ================= end of function order_is_exact ======================= */
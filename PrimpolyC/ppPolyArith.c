@@ -18,6 +18,7 @@
 |     convolve
 |     coeff_of_square
 |     coeff_of_product
+|     add_scaled_row
 |     square
 |     product
 |     times_x
@@ -53,6 +54,10 @@
 #include <stdio.h>
 #include "Primpoly.h"
 
+#if PP_RESIDUE_BITS == 8 && defined( __SSSE3__ )
+    #include <tmmintrin.h>  /* for the 16-way byte shuffle in add_scaled_row */
+#endif
+
 
 /*==============================================================================
 |                                   eval_poly                                  |
@@ -64,7 +69,7 @@ DESCRIPTION
 
 INPUT
 
-     f (int *)      nth degree mod p polynomial
+     f (residue *)  nth degree mod p polynomial
          
                               n         n-1     
                     f( x ) = x  +  a   x  + ... + a    0 <= a  < p
@@ -102,7 +107,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int
-    eval_poly( int * f, int x, int n, int p )
+    eval_poly( residue * f, int x, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -136,7 +141,7 @@ DESCRIPTION
 
 INPUT
 
-    f (int *)  nth degree monic mod p polynomial f(x). 
+    f (residue *) nth degree monic mod p polynomial f(x). 
 
     n (int)    Its degree.
 
@@ -170,7 +175,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int 
-    linear_factor( int * f, int n, int p )
+    linear_factor( residue * f, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -204,7 +209,7 @@ DESCRIPTION
 
 INPUT
 
-    t (int *)  mod p polynomial t(x). 
+    t (residue *) mod p polynomial t(x). 
     n (int)    Its degree.
 
 RETURNS
@@ -230,7 +235,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int 
-    is_integer( int * t, int n )
+    is_integer( residue * t, int n )
 {
 
 /*------------------------------------------------------------------------------
@@ -261,15 +266,17 @@ DESCRIPTION
 
 INPUT
 
-    f (int *)   Coefficients of f(x), a monic polynomial of degree n.
+    f (residue *) Coefficients of f(x), a monic polynomial of degree n.
     n (int, -infinity < n < infinity)
     p (int, p > 0)
 
 RETURNS
 
-    power_table (int *)  power_table[i][j] is the coefficient of 
+    power_table (residue *) power_table[i][j] is the coefficient of 
      j       n+i
     x   in  x   (mod f(x), p) where 0 <= i <= n-2 and 0 <= j <= n-1. 
+    gf3 (gf3table *) The same rows packed as bit planes when p = 3;  marked
+                     empty for any other p.  Skipped if NULL.
 
 EXAMPLE 
                                   4     2                     4
@@ -321,7 +328,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    construct_power_table( int power_table[][ MAXDEGPOLY ], int * f, 
+    construct_power_table( residue power_table[][ MAXDEGPOLY ], gf3table * gf3, residue * f, 
                            int n, int p )
 {
 
@@ -331,7 +338,9 @@ void
 
 int 
     i, j,                  /*  Loop counters.  */
-    coeff,                 /*  Coefficient of x ^ n in t(x) */
+    coeff ;                /*  Coefficient of x ^ n in t(x) */
+
+residue
     t[ MAXDEGPOLY + 1 ] ;  /*  t(x) is temporary storage for x ^ k (mod f(x),p)
                                n <= k <= 2n-2.  Its degree can go as high as
                                n before it is reduced again. */
@@ -380,11 +389,7 @@ for (i = 0 ;  i <= n-2 ;  ++i)
 		                                      n-1             0
        */
 
-        for (j = 0 ;  j <= n-1 ;  ++j)
-
-            t[ j ] = mod( t[ j ] + 
-                          mod( -coeff * f[ j ], p ),
-                          p ) ;
+        add_scaled_row( t, f, p - coeff, n, p ) ;
     }  /* end if */
 
 
@@ -395,6 +400,15 @@ for (i = 0 ;  i <= n-2 ;  ++i)
 
 } /* end for */
 
+/*  Bit-sliced copy for the mod 3 routines, if the caller keeps one. */
+if (gf3 != NULL)
+{
+    if (p == 3)
+        gf3_pack_power_table( power_table, gf3, n ) ;
+    else
+        gf3->n = 0 ;
+}
+
 return ;
 
 } /* ================== end of function construct_power_table =============== */
@@ -411,7 +425,7 @@ DESCRIPTION
 
 INPUT
                                              n-1
-    t (int *)   Coefficients of t(x) = t    x    + ... + t x  + t
+    t (residue *) Coefficients of t(x) = t    x    + ... + t x  + t
                                         n-1               1      0
     k (int), 0 <= k <= 2n - 2)
 
@@ -457,7 +471,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int
-    auto_convolve( int * t, int k, int lower, int upper, int p )
+    auto_convolve( residue * t, int k, int lower, int upper, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -472,6 +486,16 @@ int
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
+/*  Table products are below p, so add them all up and reduce once. */
+if (gf_table_p)
+{
+    for (i = lower ;  i <= upper ;  ++i)
+
+        sum += gf_mul_table[ t[ i ] * gf_stride + t[ k - i ] ] ;
+
+    return( sum % p ) ;
+}
+
 for (i = lower ;  i <= upper ;  ++i)
 
    sum = mod( sum + mod( t[ i ] * t[ k - i ], p ), p ) ;
@@ -491,10 +515,10 @@ DESCRIPTION
 
 INPUT
                                              n-1
-    s (int *)   Coefficients of s(x) = s    x    + ... + s x  + s
+    s (residue *) Coefficients of s(x) = s    x    + ... + s x  + s
                                         n-1               1      0  
 										     n-1
-    t (int *)   Coefficients of t(x) = t    x    + ... + t x  + t
+    t (residue *) Coefficients of t(x) = t    x    + ... + t x  + t
                                         n-1               1      0
 
     k (int), 0 <= k <= 2n - 2)
@@ -547,7 +571,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int
-    convolve( int * s, int * t, int k, int lower, int upper, int p )
+    convolve( residue * s, residue * t, int k, int lower, int upper, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -562,6 +586,16 @@ int
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
+/*  Table products are below p, so add them all up and reduce once. */
+if (gf_table_p)
+{
+    for (i = lower ;  i <= upper ;  ++i)
+
+        sum += gf_mul_table[ s[ i ] * gf_stride + t[ k - i ] ] ;
+
+    return( sum % p ) ;
+}
+
 for (i = lower ;  i <= upper ;  ++i)
 
    sum = mod( sum + mod( s[ i ] * t[ k - i ], p ), p ) ;
@@ -581,7 +615,7 @@ DESCRIPTION
  
 INPUT
 
-    t (int *)  Coefficients of t(x), of degree <= n-1.
+    t (residue *) Coefficients of t(x), of degree <= n-1.
 
     k (int, 0 <= k <= 2n-2)
 
@@ -684,7 +718,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int 
-    coeff_of_square( int * t, int k, int n, int p )
+    coeff_of_square( residue * t, int k, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -738,7 +772,7 @@ DESCRIPTION
  
 INPUT
 
-    t (int *)  Coefficients of t(x), of degree <= n-1.
+    t (residue *) Coefficients of t(x), of degree <= n-1.
 
     k (int, 0 <= k <= 2n-2)
 
@@ -864,7 +898,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 int 
-    coeff_of_product( int * s, int * t, int k, int n, int p )
+    coeff_of_product( residue * s, residue * t, int k, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -892,6 +926,113 @@ return( sum ) ;
 } /* ================== end of function coeff_of_product ==================== */
 
 
+/*==============================================================================
+|                               add_scaled_row                                 |
+================================================================================
+
+DESCRIPTION
+
+     Add a constant multiple of one polynomial to another, modulo p.
+
+INPUT
+
+    t (residue *)   Coefficients of t(x), of degree <= n-1.
+    s (residue *)   Coefficients of s(x), of degree <= n-1.
+    c (int, 0 <= c < p)
+    n (int, n >= 1)
+    p (int, p >= 2)
+
+OUTPUT
+
+    t (residue *)   Overwritten with t(x) + c s(x) (mod p).
+
+EXAMPLE
+
+    Let p = 5, t(x) = 4 x + 1, s(x) = 3 x + 2 and c = 2.  Then
+    t(x) becomes (4 + 6) x + (1 + 4) = 0 (mod 5).
+
+METHOD
+
+    This is the inner loop of every reduction mod f(x).  When p is small,
+    take c s  from row c of the multiplication table and subtract p from the
+            j
+    sum if it is p or more, avoiding any divides.  For p <= 16 with 8-bit
+    residues, row c fits in one 16-byte register and a byte shuffle looks up
+    16 products at once;  that needs an SSSE3 build (gcc -mssse3).
+
+BUGS
+
+    None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void
+    add_scaled_row( residue * t, residue * s, int c, int n, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+int 
+    j = 0,          /* Loop counter.                       */
+    sum ;           /* t[ j ] + c s[ j ] < 2p              */
+
+unsigned char
+    * row ;         /* Row c of the multiplication table.  */
+
+#if PP_RESIDUE_BITS == 8 && defined( __SSSE3__ )
+__m128i
+    row16, p16, sum16 ;
+#endif
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+if (!gf_table_p)
+{
+    for (j = 0 ;  j <= n - 1 ;  ++j)
+
+        t[ j ] = mod( t[ j ] + mod( c * s[ j ], p ), p ) ;
+
+    return ;
+}
+
+row = &gf_mul_table[ c * gf_stride ] ;
+
+#if PP_RESIDUE_BITS == 8 && defined( __SSSE3__ )
+if (p <= GFSHUFFLEMAXP)
+{
+    row16 = _mm_loadu_si128( (__m128i *) row ) ;
+    p16   = _mm_set1_epi8( (char) p ) ;
+
+    /*  Add, then take min( sum, sum - p ) as unsigned bytes:  sum - p wraps
+        around above 255 exactly when sum < p. */
+    for ( ;  j + 16 <= n ;  j += 16)
+    {
+        sum16 = _mm_add_epi8( _mm_loadu_si128( (__m128i *) &t[ j ] ),
+                              _mm_shuffle_epi8( row16, _mm_loadu_si128( (__m128i *) &s[ j ] ) ) ) ;
+
+        _mm_storeu_si128( (__m128i *) &t[ j ], 
+                          _mm_min_epu8( sum16, _mm_sub_epi8( sum16, p16 ) ) ) ;
+    }
+}
+#endif
+
+for ( ;  j <= n - 1 ;  ++j)
+{
+    sum = t[ j ] + row[ s[ j ] ] ;
+
+    t[ j ] = (residue)(sum >= p ? sum - p : sum) ;
+}
+
+} /* =================== end of function add_scaled_row ===================== */
+
+
+
 /*==============================================================================
 |                                  square                                      |
 ================================================================================
@@ -904,9 +1045,10 @@ DESCRIPTION
 
 INPUT
 
-    t (int *)              Coefficients of t (x), of degree <= n-1.
+    t (residue *)          Coefficients of t (x), of degree <= n-1.
 
-    power_table (int **)   x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    gf3 (gf3table *) Its bit planes for p = 3, or NULL.
 
     n (int, -infinity < n < infinity)  Degree of f(x).
 
@@ -914,7 +1056,7 @@ INPUT
 
 OUTPUT
                                              2
-    t (int *)              Overwritten with t (x) (mod f(x), p)
+    t (residue *)          Overwritten with t (x) (mod f(x), p)
 
 EXAMPLE 
                                     3     2        
@@ -959,7 +1101,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    square( int * t, int power_table[][ MAXDEGPOLY ], int n, int p )
+    square( residue * t, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -967,14 +1109,23 @@ void
 ------------------------------------------------------------------------------*/
 
 int 
-    i, j,                     /* Loop counters. */
-    coeff,                    /* Coefficient of x ^ k term of t(x) ^2 */
+    i,                        /* Loop counter. */
+    coeff ;                   /* Coefficient of x ^ k term of t(x) ^2 */
+
+residue
     temp[ MAXDEGPOLY + 1 ] ;  /* Temporary storage for the new t(x). */
 
 /*------------------------------------------------------------------------------
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
+/*  Modulo 3, square on bit planes instead. */
+if (p == 3 && gf3_has_power_table( gf3, n ))
+{
+    gf3_square_residues( t, gf3, n ) ;
+    return ;
+}
+
 /*
                                  0        n-1
     Compute the coefficients of x , ..., x.   These terms do not require
@@ -1000,11 +1151,7 @@ for (i = n ;  i <= 2 * n - 2 ;  ++i)
 
     if ( (coeff = coeff_of_square( t, i, n, p )) != 0 )
 
-        for (j = 0 ;  j <= n - 1 ;  ++j)
-
-            temp[ j ] = mod( temp[ j ] +
-                             mod( coeff * power_table[ i - n ] [ j ], p ),
-                             p ) ;
+        add_scaled_row( temp, power_table[ i - n ], coeff, n, p ) ;
 
 for (i = 0 ;  i <= n - 1 ;  ++i)
 
@@ -1026,11 +1173,12 @@ DESCRIPTION
 
 INPUT
 
-    s (int *)              Coefficients of s(x), of degree <= n-1.
+    s (residue *)          Coefficients of s(x), of degree <= n-1.
 
-    t (int *)              Coefficients of t(x), of degree <= n-1.
+    t (residue *)          Coefficients of t(x), of degree <= n-1.
 
-    power_table (int **)    x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    gf3 (gf3table *) Its bit planes for p = 3, or NULL.
 
     n (int, -infinity < n < infinity)  Degree of f(x).
 
@@ -1038,7 +1186,7 @@ INPUT
 
 OUTPUT
 
-    s (int *)              Overwritten with s( x ) t( x ) (mod f(x), p)
+    s (residue *)          Overwritten with s( x ) t( x ) (mod f(x), p)
 
 EXAMPLE 
                                      3    2                 2
@@ -1078,7 +1226,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-product( int  * s, int * t, int power_table[][ MAXDEGPOLY ], int n, int p )
+product( residue * s, residue * t, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -1086,14 +1234,23 @@ product( int  * s, int * t, int power_table[][ MAXDEGPOLY ], int n, int p )
 ------------------------------------------------------------------------------*/
 
 int 
-    i, j,                     /* Loop counters. */
-    coeff,                    /* Coefficient of x ^ k term of t(x) ^2 */
+    i,                        /* Loop counter. */
+    coeff ;                   /* Coefficient of x ^ k term of t(x) ^2 */
+
+residue
     temp[ MAXDEGPOLY + 1 ] ;  /* Temporary storage for the new t(x). */
 
 /*------------------------------------------------------------------------------
 |                                Function Body                                 |
 ------------------------------------------------------------------------------*/
 
+/*  Modulo 3, multiply on bit planes instead. */
+if (p == 3 && gf3_has_power_table( gf3, n ))
+{
+    gf3_product_residues( s, t, gf3, n ) ;
+    return ;
+}
+
 /*
                                  0        n-1
     Compute the coefficients of x , ..., x.   These terms do not require
@@ -1119,11 +1276,7 @@ for (i = n ;  i <= 2 * n - 2 ;  ++i)
 
     if ( (coeff = coeff_of_product( s, t, i, n, p )) != 0 )
 
-        for (j = 0 ;  j <= n - 1 ;  ++j)
-
-            temp[ j ] = mod( temp[ j ] +
-                             mod( coeff * power_table[ i - n ] [ j ], p ),
-                             p ) ;
+        add_scaled_row( temp, power_table[ i - n ], coeff, n, p ) ;
 
 for (i = 0 ;  i <= n - 1 ;  ++i)
 
@@ -1144,9 +1297,9 @@ DESCRIPTION
 
 INPUT
                                             2
-    t (int *)              Coefficients of t (x), of degree <= n-1.
+    t (residue *)          Coefficients of t (x), of degree <= n-1.
 
-    power_table (int **)    x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
 
     n (int, -infinity < n < infinity)  Degree of f(x).
 
@@ -1154,7 +1307,7 @@ INPUT
 
 OUTPUT
 
-    t (int *)              Overwritten with x t(x) (mod f(x), p)
+    t (residue *)          Overwritten with x t(x) (mod f(x), p)
 
 EXAMPLE 
                                     3       2        
@@ -1186,7 +1339,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    times_x( int * t, int power_table[][ MAXDEGPOLY ], int n, int p )
+    times_x( residue * t, residue power_table[][ MAXDEGPOLY ], int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -1221,13 +1374,8 @@ t[ 0 ] = 0 ;
 */
 
 if (coeff != 0)
-{
-    for (i = 0 ;  i <= n - 1 ;  ++i)
 
-        t[ i ] = mod( t[ i ] +
-                      mod( coeff * power_table[ 0 ] [ i ], p ),
-                      p ) ;
-}
+    add_scaled_row( t, power_table[ 0 ], coeff, n, p ) ;
 
 } /* ======================== end of function times_x ======================= */
 
@@ -1245,7 +1393,8 @@ INPUT
 
     m (int)       1 <= m <= r.  The exponent.
 
-    power_table (int **)    x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+    gf3 (gf3table *) Its bit planes for p = 3, or NULL.
 
     n (int, n >= 1)     Degree of monic polynomial f(x).
 
@@ -1253,7 +1402,7 @@ INPUT
 
 OUTPUT
 
-    g (int *)     Polynomial of degree <= n-1.
+    g (residue *) Polynomial of degree <= n-1.
 
 EXAMPLE 
                               4   2 
@@ -1367,7 +1516,7 @@ BUGS
 ------------------------------------------------------------------------------*/
 
 void 
-    x_to_power( bigint m, int * g, int power_table[][ MAXDEGPOLY ], int n, int p )
+    x_to_power( bigint m, residue * g, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
 {
 
 /*------------------------------------------------------------------------------
@@ -1397,6 +1546,13 @@ int
 printf( "x to power = x ^ %lld\n", m ) ;
 #endif
 
+/*  Modulo 3, exponentiate on bit planes instead. */
+if (p == 3 && gf3_has_power_table( gf3, n ))
+{
+    gf3_x_to_power( m, g, gf3, n ) ;
+    return ;
+}
+
 /*
     Initialize g(x) to x.  Exit right away if m = 1.
 */
@@ -1437,7 +1593,7 @@ while ( --bit_count > 0 )
 
     m <<= 1 ;       /*  Expose the next bit. */
 
-    square( g, power_table, n, p ) ;
+    square( g, power_table, gf3, n, p ) ;
 
     #ifdef DEBUG_PP_PRIMPOLY
     printf( "    after squaring, poly = \n" ) ;
@@ -0,0 +1,1372 @@
+/*==============================================================================
+|
+|  File Name:
+|
+|     ppPolyFactor.c
+|
+|  Description:
+|
+|     Arithmetic on polynomials of any degree up to MAXDEGPOLY modulo p, not
+|     reduced modulo some f(x), and factoring polynomials into their square
+|     free parts, those into products of irreducibles of equal degree, and
+|     on into irreducibles.
+|
+|  Functions:
+|
+|     poly_degree
+|     poly_divide
+|     poly_gcd
+|     power_poly
+|     square_free_factor
+|     distinct_degree_factor
+|     equal_degree_factor
+|     berlekamp_factor
+|     factor_poly
+|     is_factorization
+|     is_irreducible
+|     run_irreducible_job
+|
+|  LEGAL
+|
+|     Primpoly Version 16.3 - A Program for Computing Primitive Polynomials.
+|     Copyright (C) 1999-2024 by Sean Erik O'Connor.  All Rights Reserved.
+|
+|     This program is free software: you can redistribute it and/or modify
+|     it under the terms of the GNU General Public License as published by
+|     the Free Software Foundation, either version 3 of the License, or
+|     (at your option) any later version.
+|
+|     This program is distributed in the hope that it will be useful,
+|     but WITHOUT ANY WARRANTY; without even the implied warranty of
+|     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+|     GNU General Public License for more details.
+|
+|     You should have received a copy of the GNU General Public License
+|     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+|
+|     The author's address is seanerikoconnor!AT!gmail!DOT!com
+|     with !DOT! replaced by . and the !AT! replaced by @
+|
+==============================================================================*/
+
+/*------------------------------------------------------------------------------
+|                                Include Files                                 |
+------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h> /* for rand() function */
+
+#include "Primpoly.h"
+
+
+/*==============================================================================
+|                                 poly_degree                                  |
+================================================================================
+
+DESCRIPTION
+
+     Degree of a(x), whose coefficients are a[ 0 ], ..., a[ n ].
+
+RETURNS
+
+     The largest i <= n with a[ i ] != 0, or -1 if a(x) = 0.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int poly_degree( residue * a, int n )
+{
+    while (n >= 0 && a[ n ] == 0)
+        --n ;
+
+    return n ;
+
+} /* ==================== end of function poly_degree ======================= */
+
+
+
+/*==============================================================================
+|                                 poly_divide                                  |
+================================================================================
+
+DESCRIPTION
+
+     Divide a(x) by b(x) modulo p, giving a(x) = q(x) b(x) + r(x).
+
+INPUT
+
+     a  (residue *)   Dividend of degree na.
+     b  (residue *)   Divisor of degree nb >= 0, not necessarily monic.
+     p  (int)         Modulus.
+
+OUTPUT
+
+     q  (residue *)   Quotient of degree na - nb, if na >= nb.
+     r  (residue *)   Remainder, with nb coefficients r[ 0 ], ..., r[ nb-1 ].
+                      It may be the same array as a.
+
+RETURNS
+
+     The degree of r(x), -1 if b(x) divides a(x).
+
+EXAMPLE
+                            3                                        2
+     Let p = 2, a(x) = x  + 1 and b(x) = x + 1.  Then q(x) = x  + x + 1 and
+     r(x) = 0, so we return -1.
+
+METHOD
+
+     Long division, one leading term at a time.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int poly_divide( residue * a, int na, residue * b, int nb, residue * q, residue * r, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    t[ MAXDEGPOLY + 1 ] ;   /*  The running remainder.            */
+
+int
+    i, j,                   /*  Loop counters.                    */
+    c,                      /*  Coefficient of the next term of q. */
+    inv = inverse_mod_p( b[ nb ], p ) ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (i = 0 ;  i <= na ;  ++i)
+    t[ i ] = a[ i ] ;
+
+for (i = na - nb ;  i >= 0 ;  --i)
+{
+    c = (int)(((bigint) t[ i + nb ] * inv) % p) ;
+    q[ i ] = (residue) c ;
+
+    if (c != 0)
+
+        for (j = 0 ;  j <= nb ;  ++j)
+            t[ i + j ] = (residue)(((bigint) t[ i + j ] + (bigint)(p - c) * b[ j ]) % p) ;
+}
+
+for (i = 0 ;  i <= nb - 1 ;  ++i)
+    r[ i ] = (i <= na) ? t[ i ] : 0 ;
+
+return poly_degree( r, nb - 1 ) ;
+
+} /* ==================== end of function poly_divide ======================= */
+
+
+
+/*==============================================================================
+|                                   poly_gcd                                   |
+================================================================================
+
+DESCRIPTION
+
+     The monic greatest common divisor of a(x) and b(x) modulo p.
+
+INPUT
+
+     a, b    (residue *)  Polynomials of degree na and nb, not both zero.
+     p       (int)        Modulus.
+
+OUTPUT
+
+     g       (residue *)  gcd( a(x), b(x) ), monic.
+
+RETURNS
+
+     The degree of g(x), -1 if a(x) = b(x) = 0.
+
+METHOD
+
+     Euclid's algorithm.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int poly_gcd( residue * a, int na, residue * b, int nb, residue * g, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    u[ MAXDEGPOLY + 1 ],
+    v[ MAXDEGPOLY + 1 ],
+    q[ MAXDEGPOLY + 1 ],
+    r[ MAXDEGPOLY + 1 ] ;
+
+int
+    nu, nv, nr, i, inv ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+/*  Start with the higher degree polynomial in u(x). */
+if (poly_degree( a, na ) < poly_degree( b, nb ))
+    return poly_gcd( b, nb, a, na, g, p ) ;
+
+for (i = 0 ;  i <= na ;  ++i)
+    u[ i ] = a[ i ] ;
+
+for (i = 0 ;  i <= nb ;  ++i)
+    v[ i ] = b[ i ] ;
+
+nu = poly_degree( u, na ) ;
+nv = poly_degree( v, nb ) ;
+
+/*  (u, v) <- (v, u mod v) until v(x) = 0. */
+while (nv >= 0)
+{
+    nr = poly_divide( u, nu, v, nv, q, r, p ) ;
+
+    for (i = 0 ;  i <= nv ;  ++i)
+        u[ i ] = v[ i ] ;
+
+    nu = nv ;
+
+    for (i = 0 ;  i <= nr ;  ++i)
+        v[ i ] = r[ i ] ;
+
+    nv = nr ;
+}
+
+if (nu < 0)
+    return -1 ;
+
+inv = inverse_mod_p( u[ nu ], p ) ;
+
+for (i = 0 ;  i <= nu ;  ++i)
+    g[ i ] = (residue)(((bigint) u[ i ] * inv) % p) ;
+
+return nu ;
+
+} /* ====================== end of function poly_gcd ======================== */
+
+
+
+/*==============================================================================
+|                                  power_poly                                  |
+================================================================================
+
+DESCRIPTION
+                 e
+     Replace h(x) by h(x)  (mod f(x), p).
+
+INPUT
+
+     h           (residue *)  Polynomial of degree < n.
+     e           (bigint)     Exponent, e >= 1.
+     power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2, f monic.
+     gf3 (gf3table *) Its bit planes for p = 3, or NULL.
+     n           (int, n >= 2) Degree of f(x).
+     p           (int)        Modulus.
+
+METHOD
+
+     Square and multiply on the bits of e, from the leading bit down, as in
+     x_to_power().
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void power_poly( residue * h, bigint e, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    base[ MAXDEGPOLY ] ;    /*  The original h(x).            */
+
+bigint
+    mask = ((bigint)1 << (NUMBITS - 1)) ;
+
+int
+    i ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (i = 0 ;  i <= n - 1 ;  ++i)
+    base[ i ] = h[ i ] ;
+
+/*  Find the leading bit of e;  h(x) already holds that power. */
+while (! (e & mask))
+    mask >>= 1 ;
+
+for (mask >>= 1 ;  mask != 0 ;  mask >>= 1)
+{
+    square( h, power_table, gf3, n, p ) ;
+
+    if (e & mask)
+        product( h, base, power_table, gf3, n, p ) ;
+}
+
+} /* ===================== end of function power_poly ======================= */
+
+
+
+/*==============================================================================
+|                              square_free_factor                              |
+================================================================================
+
+DESCRIPTION
+                                          e1         ek
+     Write the monic polynomial f(x) = a1(x)  ... ak(x)   modulo p, where the
+     ai(x) are square free, pairwise relatively prime, and the ei distinct.
+
+INPUT
+
+     f       (residue *)      Monic polynomial of degree n.
+     n       (int, n >= 1)    Its degree.
+     p       (int)            Prime modulus.
+
+OUTPUT
+
+     factors (poly_factor *)  ai(x), its degree and ei, for i = 1 ... k.
+                              The degrees of their irreducible factors are
+                              left 0 (unknown).
+
+RETURNS
+
+     k, the number of factors.
+
+EXAMPLE
+                                  3
+     Let p = 3 and f(x) = (x + 1)  (x + 2) = x^4 + 2 x^3 + x + 2.  Then
+                               3                                   3
+     f'(x) = x^3 + 1 = (x + 1)  so gcd( f, f' ) = (x + 1)  = x^3 + 1,
+     and we return a1(x) = x + 2 with e1 = 1 and a2(x) = x + 1 with e2 = 3.
+
+METHOD
+
+     Let c(x) = gcd( f(x), f'(x) ) and w(x) = f(x) / c(x), the product of the
+     distinct irreducible factors whose multiplicity is not a multiple of p.
+     For i = 1, 2, ... y(x) = gcd( w(x), c(x) ) holds those which divide f(x)
+     more than i times, so w(x) / y(x) is the product of those of multiplicity
+     i exactly.  Replace w by y and c by c / y.  What remains of c(x) at the
+                                                   p             1/p
+     end has f'(x) = 0, so it is a polynomial in x , and c(x)     is found by
+                                   kp                 k
+     replacing each of its terms  x    by  x .  Repeat on it, multiplying the
+     multiplicities by p.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int square_free_factor( residue * f, int n, int p, poly_factor * factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    c[ MAXDEGPOLY + 1 ],    /*  What is left to factor.                 */
+    d[ MAXDEGPOLY + 1 ],    /*  Its derivative.                         */
+    g[ MAXDEGPOLY + 1 ],    /*  Repeated part of c(x).                  */
+    w[ MAXDEGPOLY + 1 ],    /*  Product of factors of multiplicity >= i. */
+    y[ MAXDEGPOLY + 1 ],
+    q[ MAXDEGPOLY + 1 ],
+    r[ MAXDEGPOLY + 1 ] ;
+
+int
+    nc = n, nd, ng, nw, ny, /*  Their degrees.                          */
+    i, j,
+    mult  = 1,              /*  Power of p on this pass.                */
+    count = 0 ;             /*  Number of factors so far.               */
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (j = 0 ;  j <= n ;  ++j)
+    c[ j ] = f[ j ] ;
+
+for (;;)
+{
+    for (j = 1 ;  j <= nc ;  ++j)
+        d[ j - 1 ] = (residue)(((bigint)(j % p) * c[ j ]) % p) ;
+
+    nd = poly_degree( d, nc - 1 ) ;
+
+    /*  c'(x) = 0:  all of c(x) is a p th power. */
+    if (nd < 0)
+    {
+        for (j = 0 ;  j <= nc ;  ++j)
+            g[ j ] = c[ j ] ;
+
+        ng = nc ;
+        nw = 0 ;
+    }
+    else
+    {
+        ng = poly_gcd( c, nc, d, nd, g, p ) ;
+        poly_divide( c, nc, g, ng, w, r, p ) ;
+        nw = nc - ng ;
+    }
+
+    for (i = 1 ;  nw > 0 ;  ++i)
+    {
+        ny = poly_gcd( w, nw, g, ng, y, p ) ;
+
+        if (nw > ny)
+        {
+            poly_divide( w, nw, y, ny, q, r, p ) ;
+
+            for (j = 0 ;  j <= nw - ny ;  ++j)
+                factors[ count ].poly[ j ] = q[ j ] ;
+
+            factors[ count ].degree        = nw - ny ;
+            factors[ count ].multiplicity  = i * mult ;
+            factors[ count ].factor_degree = 0 ;
+            factors[ count ].order         = 0 ;
+            ++count ;
+        }
+
+        for (j = 0 ;  j <= ny ;  ++j)
+            w[ j ] = y[ j ] ;
+
+        nw = ny ;
+
+        poly_divide( g, ng, y, ny, q, r, p ) ;
+
+        for (j = 0 ;  j <= ng - ny ;  ++j)
+            g[ j ] = q[ j ] ;
+
+        ng -= ny ;
+    }
+
+    if (ng == 0)
+        break ;
+
+    /*  Take the p th root of g(x) and factor it next. */
+    nc = ng / p ;
+
+    for (j = 0 ;  j <= nc ;  ++j)
+        c[ j ] = g[ j * p ] ;
+
+    mult *= p ;
+}
+
+return count ;
+
+} /* ================= end of function square_free_factor =================== */
+
+
+
+/*==============================================================================
+|                            distinct_degree_factor                            |
+================================================================================
+
+DESCRIPTION
+
+     Split a square free polynomial a(x) into the products of its irreducible
+     factors of each degree.
+
+INPUT
+
+     a       (poly_factor *)  Monic, square free a(x), its degree and
+                              multiplicity.
+     p       (int)            Prime modulus.
+
+OUTPUT
+
+     factors (poly_factor *)  The products, with the degree of the
+                              irreducibles each one holds in factor_degree,
+                              and the multiplicity of a(x).
+
+RETURNS
+
+     The number of products.
+
+EXAMPLE
+                                           2
+     Let p = 2 and a(x) = x (x + 1) (x  + x + 1).  Then we return x^2 + x
+                                   2
+     with factor degree 1 and x  + x + 1 with factor degree 2.
+
+METHOD
+                                   p^i
+     For i = 1, 2, ... gcd( g(x), x    - x ) is the product of the degree i
+     factors of g(x), which starts as a(x) and has them divided out as they
+                                                               p^i
+     are found.  We need only its power table to step h(x) = x    (mod g(x))
+     one Frobenius power at a time.  Once deg g < 2 i, what remains of g(x)
+     is irreducible.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int distinct_degree_factor( poly_factor * a, int p, poly_factor * factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ], /*  For g(x).           */
+    g[ MAXDEGPOLY + 1 ],    /*  Unfactored part of a(x).                 */
+    h[ MAXDEGPOLY + 1 ],    /*  x ^ (p ^ i) (mod g(x), p)                */
+    t[ MAXDEGPOLY + 1 ],    /*  h(x) - x                                 */
+    d[ MAXDEGPOLY + 1 ],    /*  Product of the degree i factors.         */
+    q[ MAXDEGPOLY + 1 ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+int
+    m = a->degree,          /*  Degree of g(x).                          */
+    nd,                     /*  Degree of d(x).                          */
+    i, j,
+    new_table = YES,        /*  YES when g(x) has changed.               */
+    count = 0 ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (j = 0 ;  j <= m ;  ++j)
+    g[ j ] = a->poly[ j ] ;
+
+for (j = 0 ;  j <= m ;  ++j)
+    h[ j ] = 0 ;
+
+if (m >= 2)
+    h[ 1 ] = 1 ;
+
+for (i = 1 ;  m >= 2 * i ;  ++i)
+{
+    if (new_table)
+    {
+        construct_power_table( power_table, &gf3, g, m, p ) ;
+        new_table = NO ;
+    }
+
+    power_poly( h, (bigint) p, power_table, &gf3, m, p ) ;
+
+    for (j = 0 ;  j <= m - 1 ;  ++j)
+        t[ j ] = h[ j ] ;
+
+    t[ 1 ] = (residue)((t[ 1 ] + p - 1) % p) ;
+
+    nd = poly_gcd( g, m, t, m - 1, d, p ) ;
+
+    if (nd > 0)
+    {
+        for (j = 0 ;  j <= nd ;  ++j)
+            factors[ count ].poly[ j ] = d[ j ] ;
+
+        factors[ count ].degree        = nd ;
+        factors[ count ].multiplicity  = a->multiplicity ;
+        factors[ count ].factor_degree = i ;
+        factors[ count ].order         = 0 ;
+        ++count ;
+
+        /*  Divide them out and reduce h(x) modulo the rest. */
+        poly_divide( g, m, d, nd, q, t, p ) ;
+
+        for (j = 0 ;  j <= m - nd ;  ++j)
+            g[ j ] = q[ j ] ;
+
+        poly_divide( h, m - 1, g, m - nd, q, h, p ) ;
+
+        m -= nd ;
+        new_table = YES ;
+    }
+}
+
+/*  The rest is a single irreducible. */
+if (m > 0)
+{
+    for (j = 0 ;  j <= m ;  ++j)
+        factors[ count ].poly[ j ] = g[ j ] ;
+
+    factors[ count ].degree        = m ;
+    factors[ count ].multiplicity  = a->multiplicity ;
+    factors[ count ].factor_degree = m ;
+    factors[ count ].order         = 0 ;
+    ++count ;
+}
+
+return count ;
+
+} /* =============== end of function distinct_degree_factor ================= */
+
+
+
+/*==============================================================================
+|                             equal_degree_factor                              |
+================================================================================
+
+DESCRIPTION
+
+     Split a product of distinct irreducibles of the same degree d into its
+     irreducible factors by the method of Cantor and Zassenhaus.
+
+INPUT
+
+     a       (poly_factor *)  Monic, square free a(x), its degree, its
+                              multiplicity, and d in factor_degree.
+     p       (int)            Prime modulus.
+
+OUTPUT
+
+     factors (poly_factor *)  The irreducible factors of a(x), with the
+                              multiplicity of a(x).
+
+RETURNS
+
+     The number of factors, a->degree / d.
+
+EXAMPLE
+                        2                                            2
+     Let p = 5, d = 1, a(x) = x  + 4 = (x + 1) (x + 4).  For u(x) = x, u  - 1
+                                                                   2
+     = a(x) and the gcd doesn't split it, but for u(x) = x + 2, (x + 2)  - 1
+     = 4x + 4 (mod a(x), 5) and the gcd is x + 1.
+
+METHOD
+                             d
+     The ring of polynomials mod a(x) is a product of copies of GF( p  ), one
+                                                                    d
+     for each factor.  For random u(x), the power w(x) = u(x) ^ ((p  - 1)/2)
+     is +1 or -1 in each copy, independently and with equal odds, unless it
+     is 0, so gcd( a(x), w(x) - 1 ) splits a(x) about half the time.  We find
+                                                           d-1
+                                                    p     p
+     w(x) as the (p-1)/2 power of the norm u(x) u(x)  ... u(x)     so the
+                 d
+     exponent (p  - 1)/2 can't overflow.  For p = 2 we take the trace,
+                    2           2^(d-1)
+     w(x) = u(x) + u (x) + ... u       (x),  which is 0 or 1 in each copy
+     instead.  Then split each factor of a(x) found, the same way.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int equal_degree_factor( poly_factor * a, int p, poly_factor * factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ], /*  For a(x).           */
+    u[ MAXDEGPOLY + 1 ],    /*  Random polynomial of degree < m.         */
+    t[ MAXDEGPOLY + 1 ],    /*  Its Frobenius powers u ^ (p ^ i).        */
+    w[ MAXDEGPOLY + 1 ],    /*  Their product or sum.                    */
+    g[ MAXDEGPOLY + 1 ] ;   /*  gcd( a(x), w(x) ), and the cofactor.     */
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+poly_factor
+    part ;                  /*  A factor of a(x) to split further.       */
+
+int
+    m = a->degree,
+    d = a->factor_degree,
+    ng,                     /*  Degree of g(x).                          */
+    i, j,
+    count ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+/*  Already irreducible. */
+if (m <= d)
+{
+    factors[ 0 ] = *a ;
+    return 1 ;
+}
+
+construct_power_table( power_table, &gf3, a->poly, m, p ) ;
+
+for (;;)
+{
+    /*  A random u(x) of degree 1 to m - 1. */
+    for (j = 0 ;  j <= m - 1 ;  ++j)
+        u[ j ] = (residue)(rand() % p) ;
+
+    if (poly_degree( u, m - 1 ) < 1)
+        continue ;
+
+    for (j = 0 ;  j <= m - 1 ;  ++j)
+        t[ j ] = w[ j ] = u[ j ] ;
+
+    for (i = 1 ;  i <= d - 1 ;  ++i)
+    {
+        power_poly( t, (bigint) p, power_table, &gf3, m, p ) ;
+
+        if (p == 2)
+            for (j = 0 ;  j <= m - 1 ;  ++j)
+                w[ j ] ^= t[ j ] ;
+        else
+            product( w, t, power_table, &gf3, m, p ) ;
+    }
+
+    if (p > 2)
+    {
+        if (p > 3)
+            power_poly( w, (bigint)((p - 1) / 2), power_table, &gf3, m, p ) ;
+
+        w[ 0 ] = (residue)((w[ 0 ] + p - 1) % p) ;
+    }
+
+    ng = poly_gcd( a->poly, m, w, m - 1, g, p ) ;
+
+    if (ng > 0 && ng < m)
+        break ;
+}
+
+/*  Split g(x) and a(x) / g(x) in turn. */
+for (j = 0 ;  j <= ng ;  ++j)
+    part.poly[ j ] = g[ j ] ;
+
+part.degree        = ng ;
+part.multiplicity  = a->multiplicity ;
+part.factor_degree = d ;
+part.order         = 0 ;
+
+count = equal_degree_factor( &part, p, factors ) ;
+
+poly_divide( a->poly, m, g, ng, part.poly, w, p ) ;
+part.degree = m - ng ;
+
+return count + equal_degree_factor( &part, p, &factors[ count ] ) ;
+
+} /* ================= end of function equal_degree_factor ================== */
+
+
+
+/*==============================================================================
+|                               berlekamp_factor                               |
+================================================================================
+
+DESCRIPTION
+
+     Split a square free polynomial into its irreducible factors by
+     Berlekamp's method, which is fastest for small p.
+
+INPUT
+
+     a       (poly_factor *)  Monic, square free a(x), its degree and
+                              multiplicity.
+     p       (int)            Prime modulus.
+
+OUTPUT
+
+     factors (poly_factor *)  The irreducible factors of a(x), with the
+                              multiplicity of a(x).
+
+RETURNS
+
+     The number of factors.
+
+EXAMPLE
+                        4
+     Let p = 5 and a(x) = x  + 4.  Q = I, so the kernel of Q - I has
+                                      2   3
+     the basis vectors 1, x, x , x , and the gcds of a(x) with
+     x - s for s = 1 ... 4 give the factors x + 4, x + 3, x + 2, x + 1.
+
+METHOD
+                                              p
+     The polynomials v(x) of degree < m with v  = v (mod a(x), p) form the
+     left kernel of Q - I, of dimension k, the number of irreducible
+     factors.  We find a basis by Knuth's Algorithm 4.6.2N, where the
+     vectors without a pivot in their row come out directly.  Each basis
+     vector v(x) other than 1 is a constant modulo each irreducible factor,
+     and
+                        p-1
+            a(x) = product  gcd( a(x), v(x) - s )
+                        s=0
+
+     so we split every factor found so far by every basis vector until we
+     have k of them.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int berlekamp_factor( poly_factor * a, int p, poly_factor * factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ], /*  For a(x).           */
+    C[ MAXDEGPOLY ][ MAXDEGPOLY ],               /*  Q - I, transposed.  */
+    xp[ MAXDEGPOLY ],       /*  x ^ p (mod a(x), p)                      */
+    basis[ MAXDEGPOLY ][ MAXDEGPOLY ],           /*  Kernel of Q - I     */
+    t[ MAXDEGPOLY + 1 ],    /*  A row of Q, then v(x) - s                */
+    g[ MAXDEGPOLY + 1 ],    /*  gcd( factor, v(x) - s )                  */
+    q[ MAXDEGPOLY + 1 ],
+    r[ MAXDEGPOLY + 1 ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+int
+    pivot[ MAXDEGPOLY ],    /*  Row where each column has its pivot, -1
+                                for none yet.                            */
+    m = a->degree,
+    k = 0,                  /*  Number of basis vectors.                 */
+    count = 1,              /*  Factors so far.                          */
+    row, col, i, j, b, s,
+    c, e, nt, ng, nf ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+factors[ 0 ] = *a ;
+factors[ 0 ].factor_degree = m ;
+factors[ 0 ].order         = 0 ;
+
+if (m <= 1)
+    return 1 ;
+
+construct_power_table( power_table, &gf3, a->poly, m, p ) ;
+
+for (col = 0 ;  col < m ;  ++col)
+    pivot[ col ] = -1 ;
+
+/*                      pk
+    Row k of Q is x  (mod a(x), p).  Step from one row to the next by
+          p
+    times x :  p shifts for small p, else one product.  Store Q - I
+    transposed, so the column operations below are scaled row additions.
+*/
+for (j = 0 ;  j < m ;  ++j)
+    t[ j ] = xp[ j ] = 0 ;
+
+t[ 0 ] = 1 ;
+
+if (p >= m)
+    x_to_power( (bigint) p, xp, power_table, &gf3, m, p ) ;
+
+for (row = 0 ;  row < m ;  ++row)
+{
+    for (col = 0 ;  col < m ;  ++col)
+        C[ col ][ row ] = t[ col ] ;
+
+    C[ row ][ row ] = (residue)((C[ row ][ row ] + p - 1) % p) ;
+
+    if (p < m)
+        for (s = 0 ;  s < p ;  ++s)
+            times_x( t, power_table, m, p ) ;
+    else
+        product( t, xp, power_table, &gf3, m, p ) ;
+}
+
+
+/*  Column reduce, row by row, reading off a basis vector from each row
+    without a pivot. */
+for (row = 0 ;  row < m ;  ++row)
+{
+    for (col = 0 ;  col < m ;  ++col)
+        if (C[ col ][ row ] != 0 && pivot[ col ] < 0)
+            break ;
+
+    if (col < m)
+    {
+        /*  Scale the pivot column so the pivot is -1. */
+        c = p - inverse_mod_p( C[ col ][ row ], p ) ;
+
+        for (i = 0 ;  i < m ;  ++i)
+            C[ col ][ i ] = (residue)(((bigint) C[ col ][ i ] * c) % p) ;
+
+        /*  Clear the rest of the row. */
+        for (j = 0 ;  j < m ;  ++j)
+
+            if (j != col && (e = C[ j ][ row ]) != 0)
+
+                add_scaled_row( C[ j ], C[ col ], e, m, p ) ;
+
+        pivot[ col ] = row ;
+    }
+    else
+    {
+        for (j = 0 ;  j < m ;  ++j)
+            basis[ k ][ j ] = 0 ;
+
+        basis[ k ][ row ] = 1 ;
+
+        for (j = 0 ;  j < m ;  ++j)
+            if (pivot[ j ] >= 0)
+                basis[ k ][ pivot[ j ] ] = C[ j ][ row ] ;
+
+        ++k ;
+    }
+}
+
+
+/*  basis[ 0 ] = 1 splits nothing.  Split with the rest until we have k
+    factors. */
+for (b = 1 ;  b < k && count < k ;  ++b)
+{
+    for (i = 0 ;  i < count && count < k ;  ++i)
+    {
+        nf = factors[ i ].degree ;
+
+        for (s = 0 ;  s < p && nf > 1 && count < k ;  ++s)
+        {
+            for (j = 0 ;  j < m ;  ++j)
+                t[ j ] = basis[ b ][ j ] ;
+
+            t[ 0 ] = (residue)((t[ 0 ] + p - s) % p) ;
+            nt = poly_degree( t, m - 1 ) ;
+
+            ng = poly_gcd( factors[ i ].poly, nf, t, nt, g, p ) ;
+
+            if (ng > 0 && ng < nf)
+            {
+                poly_divide( factors[ i ].poly, nf, g, ng, q, r, p ) ;
+
+                factors[ count ] = factors[ i ] ;
+
+                for (j = 0 ;  j <= nf - ng ;  ++j)
+                    factors[ count ].poly[ j ] = q[ j ] ;
+
+                factors[ count ].degree        = nf - ng ;
+                factors[ count ].factor_degree = nf - ng ;
+                ++count ;
+
+                for (j = 0 ;  j <= ng ;  ++j)
+                    factors[ i ].poly[ j ] = g[ j ] ;
+
+                factors[ i ].degree        = ng ;
+                factors[ i ].factor_degree = ng ;
+                nf = ng ;
+            }
+        }
+    }
+}
+
+return count ;
+
+} /* ================== end of function berlekamp_factor ==================== */
+
+
+
+/*==============================================================================
+|                                 factor_poly                                  |
+================================================================================
+
+DESCRIPTION
+
+     Factor a monic polynomial modulo p into irreducibles.
+
+INPUT
+
+     f       (residue *)      Monic polynomial of degree n.
+     n       (int, n >= 1)    Its degree.
+     p       (int)            Prime modulus.
+
+OUTPUT
+
+     factors (poly_factor *)  Its distinct irreducible factors and their
+                              multiplicities, by increasing degree and then
+                              coefficients.  Room for n of them.
+
+RETURNS
+
+     The number of distinct irreducible factors.
+
+EXAMPLE
+                       5    3    2                   3   2
+     Let p = 2, f(x) = x  + x  + x  + 1.  We return (x + 1)  (x  + x + 1)
+     as x + 1 with multiplicity 3 and x^2 + x + 1 with multiplicity 1.
+
+METHOD
+
+     Square free factorization first.  For p up to BERLEKAMP_MAXP and
+     below the degree of the square free part, split it with Berlekamp's
+     method, whose n x n linear algebra then costs less than the powers
+     x^p^k mod the part;  otherwise split it by distinct degree
+     factorization and each product of equal degree irreducibles by
+     Cantor and Zassenhaus.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int factor_poly( residue * f, int n, int p, poly_factor * factors )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+poly_factor
+    square_free[ MAXDEGPOLY ],  /*  Square free parts of f(x).           */
+    same_degree[ MAXDEGPOLY ],  /*  Products of equal degree factors.    */
+    temp ;
+
+int
+    num_square_free,
+    num_same_degree,
+    count = 0,
+    i, j, k ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+num_square_free = square_free_factor( f, n, p, square_free ) ;
+
+for (i = 0 ;  i < num_square_free ;  ++i)
+{
+    if (p <= BERLEKAMP_MAXP && p < square_free[ i ].degree)
+    {
+        count += berlekamp_factor( &square_free[ i ], p, &factors[ count ] ) ;
+        continue ;
+    }
+
+    num_same_degree = distinct_degree_factor( &square_free[ i ], p, same_degree ) ;
+
+    for (j = 0 ;  j < num_same_degree ;  ++j)
+        count += equal_degree_factor( &same_degree[ j ], p, &factors[ count ] ) ;
+}
+
+/*  Insertion sort by degree, then coefficients from the top down. */
+for (i = 1 ;  i < count ;  ++i)
+{
+    temp = factors[ i ] ;
+
+    for (j = i - 1 ;  j >= 0 ;  --j)
+    {
+        if (factors[ j ].degree < temp.degree)
+            break ;
+
+        if (factors[ j ].degree == temp.degree)
+        {
+            for (k = temp.degree ;  k > 0 && factors[ j ].poly[ k ] == temp.poly[ k ] ;  --k)
+                ;
+
+            if (factors[ j ].poly[ k ] < temp.poly[ k ])
+                break ;
+        }
+
+        factors[ j + 1 ] = factors[ j ] ;
+    }
+
+    factors[ j + 1 ] = temp ;
+}
+
+return count ;
+
+} /* ===================== end of function factor_poly ====================== */
+
+
+
+/*==============================================================================
+|                               is_factorization                               |
+================================================================================
+
+DESCRIPTION
+
+     Independent check on factor_poly():  the factors are irreducible and
+     their product, with multiplicities, is f(x).
+
+INPUT
+
+     f       (residue *)      Monic polynomial of degree n.
+     n       (int)            Its degree.
+     p       (int)            Prime modulus.
+     factors (poly_factor *)  Its claimed factorization ...
+     count   (int)            ... into this many distinct factors.
+
+RETURNS
+
+     YES if the factorization is right, NO if not.
+
+METHOD
+
+     Multiply out the factors by schoolbook multiplication.  Distinct degree
+     factorization of an irreducible of degree m leaves it whole, with
+     factor degree m.
+
+BUGS
+
+     Doesn't check that the factors are distinct.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int is_factorization( residue * f, int n, int p, poly_factor * factors, int count )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    prod[ MAXDEGPOLY + 1 ], /*  Product so far.                          */
+    next[ MAXDEGPOLY + 1 ] ;
+
+poly_factor
+    pieces[ MAXDEGPOLY ] ;
+
+int
+    np = 0,                 /*  Degree of the product.                   */
+    i, j, k, e ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+prod[ 0 ] = 1 ;
+
+for (i = 0 ;  i < count ;  ++i)
+{
+    if (factors[ i ].degree < 1 || factors[ i ].poly[ factors[ i ].degree ] != 1)
+        return NO ;
+
+    if (distinct_degree_factor( &factors[ i ], p, pieces ) != 1 ||
+        pieces[ 0 ].factor_degree != factors[ i ].degree)
+        return NO ;
+
+    for (e = 1 ;  e <= factors[ i ].multiplicity ;  ++e)
+    {
+        if (np + factors[ i ].degree > n)
+            return NO ;
+
+        for (j = 0 ;  j <= np + factors[ i ].degree ;  ++j)
+            next[ j ] = 0 ;
+
+        for (j = 0 ;  j <= np ;  ++j)
+            for (k = 0 ;  k <= factors[ i ].degree ;  ++k)
+                next[ j + k ] = (residue)(((bigint) next[ j + k ] + 
+                                (bigint) prod[ j ] * factors[ i ].poly[ k ]) % p) ;
+
+        np += factors[ i ].degree ;
+
+        for (j = 0 ;  j <= np ;  ++j)
+            prod[ j ] = next[ j ] ;
+    }
+}
+
+if (np != n)
+    return NO ;
+
+for (j = 0 ;  j <= n ;  ++j)
+    if (prod[ j ] != f[ j ])
+        return NO ;
+
+return YES ;
+
+} /* ================== end of function is_factorization ==================== */
+
+
+
+/*==============================================================================
+|                                is_irreducible                                |
+================================================================================
+
+DESCRIPTION
+
+     Test whether a monic polynomial is irreducible modulo p.
+
+INPUT
+
+     f           (residue *)  Monic polynomial of degree n.
+     power_table (residue **) x ^ k (mod f(x), p) for n <= k <= 2n-2.
+     gf3 (gf3table *) Its bit planes for p = 3, or NULL.
+     n           (int, n >= 2) Its degree.
+     p           (int)        Prime modulus.
+
+RETURNS
+
+     YES if f(x) is irreducible, NO if not.
+
+EXAMPLE
+                        4    2         2         2                         2
+     For p = 2, f(x) = x  + x  + 1 = (x  + x + 1) .  At i = 1, gcd( f(x), x  - x )
+                                    4
+     = 1, but at i = 2, gcd( f(x), x  - x ) = x^2 + x + 1, so we return NO.
+
+METHOD
+                                         p^i
+     Ben-Or's test:  f(x) is reducible if gcd( f(x), x    - x ) != 1 for
+     some i <= n/2, since that gcd is the product of its irreducible factors
+     of degree dividing i, and one of them has degree at most n/2.  Most
+     reducible polynomials have a small factor, so we stop at the first i
+     which finds one;  irreducibles take all n/2 Frobenius powers.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+int is_irreducible( residue * f, residue power_table[][ MAXDEGPOLY ], gf3table * gf3, int n, int p )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+residue
+    h[ MAXDEGPOLY + 1 ],    /*  x ^ (p ^ i) (mod f(x), p)                */
+    t[ MAXDEGPOLY + 1 ],    /*  h(x) - x                                 */
+    g[ MAXDEGPOLY + 1 ] ;   /*  gcd( f(x), h(x) - x )                    */
+
+int
+    i, j ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+/*  x divides f(x). */
+if (f[ 0 ] == 0)
+    return NO ;
+
+for (j = 0 ;  j <= n - 1 ;  ++j)
+    h[ j ] = 0 ;
+
+h[ 1 ] = 1 ;
+
+for (i = 1 ;  i <= n / 2 ;  ++i)
+{
+    power_poly( h, (bigint) p, power_table, gf3, n, p ) ;
+
+    for (j = 0 ;  j <= n - 1 ;  ++j)
+        t[ j ] = h[ j ] ;
+
+    t[ 1 ] = (residue)((t[ 1 ] + p - 1) % p) ;
+
+    if (poly_gcd( f, n, t, n - 1, g, p ) > 0)
+        return NO ;
+}
+
+return YES ;
+
+} /* =================== end of function is_irreducible ===================== */
+
+
+
+/*==============================================================================
+|                             run_irreducible_job                              |
+================================================================================
+
+DESCRIPTION
+
+     Test a slice of a batch of polynomials for irreducibility.  Has the
+     signature of a POSIX thread start routine so main() can test several
+     slices at once.
+
+INPUT
+
+     job    (irreducible_job *)  The batch, the slice, n and p.
+
+OUTPUT
+
+     job    (irreducible_job *)  is_irreducible[ k ] filled in for the slice.
+
+RETURNS
+
+     NULL.
+
+BUGS
+
+     None.
+
+--------------------------------------------------------------------------------
+|                                Function Call                                 |
+------------------------------------------------------------------------------*/
+
+void * run_irreducible_job( void * job )
+{
+
+/*------------------------------------------------------------------------------
+|                               Local Variables                                |
+------------------------------------------------------------------------------*/
+
+irreducible_job * ij = (irreducible_job *) job ;
+
+residue
+    power_table[ MAXDEGPOLY - 1 ][ MAXDEGPOLY ] ;
+
+gf3table
+    gf3 ;                          /*  Bit planes of the powers for p = 3. */
+
+int
+    k ;
+
+/*------------------------------------------------------------------------------
+|                                Function Body                                 |
+------------------------------------------------------------------------------*/
+
+for (k = ij->first ;  k < ij->last ;  ++k)
+{
+    construct_power_table( power_table, &gf3, ij->polys[ k ], ij->n, ij->p ) ;
+
+    ij->is_irreducible[ k ] = is_irreducible( ij->polys[ k ], power_table, &gf3, ij->n, ij->p ) ;
+}
+
+return NULL ;
+
+} /* ================= end of function run_irreducible_job =================== */